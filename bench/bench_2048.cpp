@@ -0,0 +1,127 @@
+#include "bench_2048.hpp"
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/*
+ * Microbenchmarks of the solver primitives and of one Bellman time step,
+ * for the board sizes and the objectives given on the command line.
+ *   bench_2048 [objective ...] [--board RxC ...] [--threads N] [--min-time S] [--output FILE]
+ * Prints ns/op and operations (or states) per second, and writes the same
+ * results as JSON to FILE (bench_2048.json by default).
+ */
+
+namespace {
+
+std::pair<int, int> parse_board(const std::string& text) {
+    const std::size_t separator = text.find('x');
+    if (separator == std::string::npos) {
+        throw std::invalid_argument("Invalid board " + text + " (expected rows x cols, eg 3x3)");
+    }
+    const int rows = std::stoi(text.substr(0, separator));
+    const int cols = std::stoi(text.substr(separator + 1));
+    if (!is_supported_board(rows, cols)) {
+        throw std::invalid_argument("Unsupported board " + text + ", this build plays " + supported_boards());
+    }
+    return {rows, cols};
+}
+
+BenchOptions parse_options(int argc, char* argv[]) {
+    BenchOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) != 0) {
+            options.objectives.push_back(std::stoi(arg));
+            continue;
+        }
+        if (i + 1 >= argc) {
+            throw std::invalid_argument("Missing value for " + arg);
+        }
+        std::string value = argv[++i];
+        if (arg == "--board") {
+            options.boards.push_back(parse_board(value));
+        } else if (arg == "--threads") {
+            options.threads = std::stoi(value);
+        } else if (arg == "--min-time") {
+            options.min_seconds = std::stod(value);
+        } else if (arg == "--output") {
+            options.output = value;
+        } else {
+            throw std::invalid_argument("Unknown option: " + arg);
+        }
+    }
+    if (options.boards.empty()) {
+        options.boards.emplace_back(DEFAULT_BOARD_ROWS, DEFAULT_BOARD_COLS);
+    }
+    if (options.objectives.empty()) {
+        options.objectives.push_back(WINNING_TILE_POWER);
+    }
+    return options;
+}
+
+std::vector<BenchResult> bench_objective(const BenchOptions& options, int rows, int cols, int winning_objective) {
+#define DISPATCH_BENCH_BOARD(ROWS, COLS) \
+    if (rows == ROWS && cols == COLS) return board_##ROWS##x##COLS::bench_objective(options, winning_objective);
+    FOR_EACH_BOARD_SIZE(DISPATCH_BENCH_BOARD)
+#undef DISPATCH_BENCH_BOARD
+    return {};
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    try {
+        options = parse_options(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\nUsage: " << argv[0]
+                  << " [objective ...] [--board RxC ...] [--threads N] [--min-time S] [--output FILE]" << std::endl;
+        return 1;
+    }
+#ifdef PACKED_STATE
+    const bool packed_state = true;
+#else
+    const bool packed_state = false;
+#endif
+
+    std::vector<BenchResult> results;
+    for (const auto& [rows, cols] : options.boards) {
+        for (int winning_objective : options.objectives) {
+            std::cout << "Board " << rows << "x" << cols << ", objective " << (1 << winning_objective)
+                      << (packed_state ? ", packed state" : "") << ", " << options.threads << " thread(s)" << std::endl;
+            for (const BenchResult& result : bench_objective(options, rows, cols, winning_objective)) {
+                std::cout << "  " << std::left << std::setw(32) << result.name << std::right
+                          << std::setw(12) << std::fixed << std::setprecision(2) << result.ns_per_op << " ns/op"
+                          << std::setw(16) << std::setprecision(0) << result.ops_per_second
+                          << (result.name.rfind("bellman", 0) == 0 ? " states/s" : " ops/s") << std::endl;
+                results.push_back(result);
+            }
+        }
+    }
+
+    std::ofstream out(options.output);
+    out << "[\n";
+    for (size_t k = 0; k < results.size(); k++) {
+        const BenchResult& result = results[k];
+        out << "  {\"rows\": " << result.rows << ", \"cols\": " << result.cols
+            << ", \"objective\": " << result.winning_objective
+            << ", \"packed_state\": " << (packed_state ? "true" : "false")
+            << ", \"threads\": " << options.threads
+            << ", \"name\": \"" << result.name << "\""
+            << ", \"ns_per_op\": " << std::setprecision(3) << std::fixed << result.ns_per_op
+            << ", \"ops_per_second\": " << std::setprecision(0) << result.ops_per_second
+            << ", \"operations\": " << result.operations << "}"
+            << (k + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "]\n";
+    if (!out) {
+        std::cerr << "Cannot write " << options.output << std::endl;
+        return 1;
+    }
+    std::cout << "Results written to " << options.output << std::endl;
+    return 0;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "board_sizes.hpp"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct BenchResult {
+    int rows;
+    int cols;
+    int winning_objective;
+    std::string name;
+    double ns_per_op;
+    double ops_per_second;
+    int64_t operations;
+};
+
+struct BenchOptions {
+    // (rows, cols) of the boards to benchmark, the default board when empty
+    std::vector<std::pair<int, int>> boards;
+    // objectives, WINNING_TILE_POWER when empty
+    std::vector<int> objectives;
+    int threads = 1;
+    double min_seconds = 0.2;
+    std::string output = "bench_2048.json";
+};
+
+// Benchmarks of one board size, see bench_board.cpp (compiled once per size)
+#define DECLARE_BENCH_BOARD(ROWS, COLS) \
+    namespace board_##ROWS##x##COLS { \
+    std::vector<BenchResult> bench_objective(const BenchOptions& options, int winning_objective); \
+    }
+FOR_EACH_BOARD_SIZE(DECLARE_BENCH_BOARD)
+#undef DECLARE_BENCH_BOARD
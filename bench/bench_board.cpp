@@ -0,0 +1,183 @@
+#include "bench_2048.hpp"
+#include "types.hpp"
+#include "state.hpp"
+#include "utils.hpp"
+#include "random.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/*
+ * Benchmarks of one board size, compiled once per size of BOARD_SIZES
+ * like the solver (see state.hpp), and run by bench_2048.cpp.
+ */
+
+namespace BOARD_NAMESPACE {
+
+namespace {
+
+// Boards each primitive is timed on, drawn once before timing
+constexpr int SAMPLE_BOARDS = 1 << 14;
+
+// Keeps results alive so that the timed loops are not optimised away
+volatile int64_t sink = 0;
+
+/*
+ * Runs body (operations_per_call operations) until min_seconds have elapsed,
+ * and keeps the fastest of 5 such rounds
+ */
+BenchResult run(const BenchOptions& options, int winning_objective, const std::string& name,
+                int64_t operations_per_call, const std::function<int64_t()>& body) {
+    sink = sink + body();  // warm up caches and lookup tables
+    double best_ns = 0;
+    int64_t operations = 0;
+    for (int round = 0; round < 5; round++) {
+        int64_t calls = 0;
+        int64_t checksum = 0;
+        auto start = std::chrono::steady_clock::now();
+        std::chrono::duration<double> elapsed{0};
+        do {
+            checksum += body();
+            calls++;
+            elapsed = std::chrono::steady_clock::now() - start;
+        } while (elapsed.count() < options.min_seconds / 5);
+        sink = sink + checksum;
+        const double ns = elapsed.count() * 1e9 / (calls * operations_per_call);
+        if (round == 0 || ns < best_ns) best_ns = ns;
+        operations += calls * operations_per_call;
+    }
+    return {State::ROWS, State::COLS, winning_objective, name, best_ns, 1e9 / best_ns, operations};
+}
+
+// Time steps the Bellman step is averaged over
+constexpr int BELLMAN_STEPS = 16;
+
+/*
+ * One time step of optimal_policy, from the difference between a horizon of 1 + BELLMAN_STEPS
+ * and of 1: excludes the allocation, the final reward initialisation and the transition matrix build
+ */
+BenchResult bellman_step(const BenchOptions& options, int winning_objective, bool precompute_transitions,
+                         SimdLevel simd = SimdLevel::Auto) {
+    const int64_t total_combinations = state_space_size(winning_objective);
+    Table<action_type> policy(total_combinations);
+    Table<reward_type> value(total_combinations);
+    Table<reward_type> new_value(total_combinations);
+    SolverOptions solver;
+    solver.threads = options.threads;
+    solver.precompute_transitions = precompute_transitions;
+    solver.simd = simd;
+
+    // the solver reports every time step, silence it while timing
+    std::streambuf* console = std::cout.rdbuf(nullptr);
+    auto timed_solve = [&](int T) {
+        auto start = std::chrono::steady_clock::now();
+        optimal_policy(policy, value, new_value, winning_objective, T, solver);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count();
+    };
+    double best_step = 0;
+    for (int round = 0; round < 3; round++) {
+        const double step = (timed_solve(1 + BELLMAN_STEPS) - timed_solve(1)) / BELLMAN_STEPS;
+        if (round == 0 || step < best_step) best_step = step;
+    }
+    std::cout.rdbuf(console);
+    std::cout.clear();
+
+    const double ns = std::max(best_step, 1e-12) * 1e9 / total_combinations;
+    std::string name = precompute_transitions ? "bellman_step_precomputed" : "bellman_step";
+    if (simd != SimdLevel::Auto) {
+        name += "_" + to_string(simd);
+    }
+    return {State::ROWS, State::COLS, winning_objective, name, ns, 1e9 / ns, total_combinations * BELLMAN_STEPS};
+}
+
+/*
+ * Allocation of a value table of every board, mapped and first touched on options.threads threads:
+ * the table is not written again when constructed, so the cost per state falls with more threads
+ */
+BenchResult table_allocation(const BenchOptions& options, int winning_objective) {
+    const int64_t total_combinations = state_space_size(winning_objective);
+    const util::TableOptions table_options{util::HugePages::Auto, options.threads};
+    return run(options, winning_objective, "table_allocation", total_combinations, [&]() {
+        Table<reward_type> value(total_combinations, util::TableAllocator<reward_type>(table_options));
+        return static_cast<int64_t>(value[total_combinations - 1]);
+    });
+}
+
+}  // namespace
+
+std::vector<BenchResult> bench_objective(const BenchOptions& options, int winning_objective) {
+    std::vector<BenchResult> results;
+    const int64_t total_combinations = state_space_size(winning_objective);
+
+    // sample boards over the whole state space, as the sweep visits them
+    util::Xoshiro256 generator(winning_objective);
+    std::vector<int64_t> hashes(SAMPLE_BOARDS);
+    std::vector<State> boards(SAMPLE_BOARDS);
+    for (int k = 0; k < SAMPLE_BOARDS; k++) {
+        hashes[k] = static_cast<int64_t>(generator.next() % static_cast<uint64_t>(total_combinations));
+        hash_to_gamestate(winning_objective, hashes[k], boards[k]);
+    }
+
+    for (auto a : Actions::All) {
+        if (a == Action::None) continue;
+        std::ostringstream name;
+        name << "player_move_" << a;
+        results.push_back(run(options, winning_objective, name.str(), SAMPLE_BOARDS, [&]() {
+            int64_t moved = 0;
+            for (const State& board : boards) {
+                std::optional<State> next_state = board.player_move(a);
+                moved += next_state.has_value() ? next_state.value()(0, 0) + 1 : 0;
+            }
+            return moved;
+        }));
+    }
+    results.push_back(run(options, winning_objective, "all_nature_moves", SAMPLE_BOARDS, [&]() {
+        int64_t moves = 0;
+        for (const State& board : boards) {
+            moves += static_cast<int64_t>(board.all_nature_moves().size());
+        }
+        return moves;
+    }));
+    results.push_back(run(options, winning_objective, "gamestate_to_hash", SAMPLE_BOARDS, [&]() {
+        int64_t total = 0;
+        for (const State& board : boards) {
+            total += gamestate_to_hash(winning_objective, board);
+        }
+        return total;
+    }));
+    results.push_back(run(options, winning_objective, "hash_to_gamestate", SAMPLE_BOARDS, [&]() {
+        int64_t total = 0;
+        State board;
+        for (int64_t hash : hashes) {
+            hash_to_gamestate(winning_objective, hash, board);
+            total += board(0, 0);
+        }
+        return total;
+    }));
+    results.push_back(run(options, winning_objective, "final_reward", SAMPLE_BOARDS, [&]() {
+        int64_t wins = 0;
+        for (const State& board : boards) {
+            wins += final_reward(winning_objective, board) > 0;
+        }
+        return wins;
+    }));
+    results.push_back(table_allocation(options, winning_objective));
+    results.push_back(bellman_step(options, winning_objective, false));
+    results.push_back(bellman_step(options, winning_objective, true));
+    // every instruction set of the vectorised backups this CPU supports, auto is the widest
+    for (SimdLevel level : {SimdLevel::Scalar, SimdLevel::SSE4, SimdLevel::AVX2, SimdLevel::AVX512}) {
+        if (simd_supported(level)) {
+            results.push_back(bellman_step(options, winning_objective, true, level));
+        }
+    }
+    return results;
+}
+
+}  // namespace BOARD_NAMESPACE
@@ -0,0 +1,80 @@
+#pragma once
+#include "solver_options.hpp"
+#include "search_options.hpp"
+#include "value_storage.hpp"
+#include "board_sizes.hpp"
+#include "table_allocator.hpp"
+
+#include <string>
+
+// Largest winning objective of packed boards (see packed_board.hpp): two tiles 2^14 merge into 2^15,
+// the largest 4-bit tile
+constexpr int MAX_PACKED_OBJECTIVE = 14;
+
+/**
+ * @brief Command line configuration of solver_2048.
+ * Positional arguments keep their historical meaning:
+ *   solver_2048 [winning_objective] [time_horizon] [--option value ...]
+ */
+struct CliOptions {
+    // board size, one of the sizes of this build (see board_sizes.hpp.in)
+    int rows = DEFAULT_BOARD_ROWS;
+    int cols = DEFAULT_BOARD_COLS;
+    int winning_objective = WINNING_TILE_POWER;
+    // time horizon, computed from winning_objective and the board when not given (see default_time_horizon)
+    int T = 0;
+    bool T_given = false;
+
+    // solve only the boards reachable from the empty board (see ReachableIndex)
+    bool reachable_only = false;
+    // same tables, with reachable boards looked up in a hash map instead of a bitset over all hashes (see SparseIndex)
+    bool sparse = false;
+    // solve one board per symmetry orbit (see SymmetricIndex)
+    bool symmetry = false;
+    // single pass over tile sum layers instead of T sweeps (see optimal_policy_to_completion)
+    bool solve_to_completion = false;
+    // solve to completion backing up only boards whose successors changed (see optimal_policy_prioritized)
+    bool prioritized_sweeping = false;
+    // solve every objective from first_objective to winning_objective at once, 0 for one objective
+    // (see multi_objective.hpp)
+    int first_objective = 0;
+    // objective the game, simulations and queries play for, 0 for winning_objective
+    int target_objective = 0;
+    // entries of the value tables (see value_storage.hpp)
+    ValuePrecision precision = ValuePrecision::Double;
+    // also solve with double values and report the largest difference
+    bool precision_error = false;
+    // pages of the policy and value tables (see table_allocator.hpp)
+    util::HugePages huge_pages = util::HugePages::Auto;
+
+    // write the tables to this solution file after the solve (see solution_file.hpp)
+    std::string save_path;
+    // map the tables of this solution file instead of solving,
+    // its header replaces the objective, horizon, precision and index options
+    std::string load_path;
+    // continue the solve from this solution or checkpoint file up to T,
+    // its header replaces the objective, precision and index options
+    std::string resume_path;
+
+    // answer binary board queries on stdin/stdout instead of playing (see query_server.hpp)
+    bool serve = false;
+    // answer the same queries on a Unix domain socket at this path until Ctrl+C
+    std::string socket_path;
+
+    // play this many games with the policy and report the win rate instead of playing (see simulator.hpp)
+    int64_t simulate_games = 0;
+    // Note: same default as SimulationOptions::seed
+    uint64_t seed = 2048;
+
+    SolverOptions solver;
+
+    // play with an expectimax search instead of solved tables (see expectimax.hpp), threads come from solver
+    bool search = false;
+    SearchOptions search_options;
+};
+
+/// @brief Parses argv, throws std::invalid_argument on unknown options or bad values
+CliOptions parse_cli(int argc, char* argv[]);
+
+/// @brief Short help text listing the supported options
+std::string cli_usage(const char* program_name);
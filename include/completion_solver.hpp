@@ -0,0 +1,31 @@
+#pragma once
+#include "types.hpp"
+#include "utils.hpp"
+
+#include <vector>
+
+namespace BOARD_NAMESPACE {
+
+/**
+ * @brief Solves the game to completion, without a time horizon, in a single pass.
+ * Merges keep the sum of the tiles and Nature adds 2 or 4, so every turn strictly
+ * increases the sum of a board that has not won yet: boards form a DAG layered by sum.
+ * Layers are evaluated once each, in decreasing sum order, reading successor values
+ * from the two layers above (sum + 2 and sum + 4). Boards holding the objective
+ * are worth 1 and are never stored, so at most three layers of values are in memory.
+ *
+ * Results are those of optimal_policy with a horizon long enough to converge.
+ * policy has index.size() entries, value is only filled if it has index.size() entries
+ * (pass an empty vector to skip it). Layers hold values as Storage, like value.
+ */
+template <typename Index, typename Storage>
+void optimal_policy_to_completion(Table<action_type>& policy,
+                                  Table<Storage>& value,
+                                  int winning_objective,
+                                  const Index& index,
+                                  const SolverOptions& options = SolverOptions());
+
+/// @brief Smallest horizon for which optimal_policy reaches the values of a complete solve
+int completion_time_horizon(int winning_objective);
+
+}  // namespace BOARD_NAMESPACE
@@ -0,0 +1,111 @@
+#pragma once
+#include "types.hpp"
+#include "state.hpp"
+#include "thread_pool.hpp"
+#include "search_options.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace BOARD_NAMESPACE {
+
+/*
+ * Expectimax search for boards whose state space is too large to solve: the value of
+ * a board is its probability of reaching the objective, like the solved tables, searched
+ * a limited number of player moves ahead. Player moves come from State::player_move,
+ * Nature puts a 2 or a 4 on each empty tile (all_nature_moves), each equally likely,
+ * like the Bellman backups. Won boards are worth 1 and boards without moves 0; at the
+ * search depth, and on chance branches less likely than min_probability, a board is
+ * worth evaluate_board.
+ * With a depth of at least the moves left to the horizon and no cut-off, values are
+ * those of backwards induction for that horizon.
+ */
+
+/// @brief Move picked by a search, and what it took
+struct SearchResult {
+    action_type action = Action::None;
+    // probability of reaching the objective with action, and with each player move (-1 when invalid)
+    reward_type value = 0;
+    std::array<reward_type, 4> action_values = {-1, -1, -1, -1};
+    // player moves of the deepest completed iteration
+    int depth = 0;
+    int64_t nodes = 0;
+    double seconds = 0;
+};
+
+/// @brief Totals over the moves searched so far
+struct SearchStatistics {
+    int64_t moves = 0;
+    int64_t nodes = 0;
+    // transposition table lookups, and those that found the board
+    int64_t probes = 0;
+    int64_t hits = 0;
+    // chance branches estimated because of min_probability, also counted in nodes
+    int64_t cutoffs = 0;
+    int64_t depth_sum = 0;
+    double seconds = 0;
+
+    double nodes_per_second() const { return seconds > 0 ? nodes / seconds : 0; }
+    double hit_rate() const { return probes > 0 ? static_cast<double>(hits) / probes : 0; }
+};
+std::string to_string(const SearchStatistics& statistics);
+
+/// @brief Estimate of the value of a board at the search depth, below the value of a won board
+reward_type evaluate_board(int winning_objective, const State& board);
+
+/**
+ * @brief Iterative deepening expectimax with a transposition table shared by its threads.
+ * The root is split into one task per player move and Nature move, run on a ThreadPool.
+ * Boards below which a chance branch may be cut off are searched with the probability of their
+ * path rounded up to a power of 2, which is part of their key: the value of an entry only
+ * depends on its key, and results do not depend on the threads (node counts do).
+ * Not thread-safe: one search at a time, each already uses options.threads threads.
+ */
+class ExpectimaxSearch {
+public:
+    /// @throws std::invalid_argument without a time, depth or horizon limit
+    ExpectimaxSearch(int winning_objective, const SearchOptions& options);
+    ~ExpectimaxSearch();
+
+    ExpectimaxSearch(const ExpectimaxSearch&) = delete;
+    ExpectimaxSearch& operator=(const ExpectimaxSearch&) = delete;
+
+    /**
+     * @brief Best player move on board, with moves_left player moves to the horizon
+     * (negative for no horizon). Action::None when board has won or has no move.
+     */
+    SearchResult search(const State& board, int moves_left);
+
+    const SearchStatistics& statistics() const { return statistics_; }
+    size_t table_entries() const { return table_size_; }
+
+private:
+    struct Entry;
+    struct Counters;
+
+    // counts a node, true once the iteration must stop (deadline passed)
+    bool count_node(Counters& counters);
+    // value of board, whose player moves next, and of afterstate, whose Nature moves next
+    reward_type max_node(const State& board, int depth, int moves_left, double probability, Counters& counters);
+    reward_type chance_node(const State& afterstate, int depth, int moves_left, double probability, Counters& counters);
+    uint64_t board_key(const State& board) const;
+
+    int winning_objective_;
+    SearchOptions options_;
+    util::ThreadPool pool_;
+    // Zobrist keys of each tile on each cell
+    std::array<std::array<uint64_t, 16>, State::SIZE> tile_keys_;
+    std::unique_ptr<Entry[]> table_;
+    size_t table_size_ = 0;
+    // the iteration in progress stops once the deadline has passed
+    std::chrono::steady_clock::time_point deadline_;
+    bool has_deadline_ = false;
+    std::atomic<bool> stop_{false};
+    SearchStatistics statistics_;
+};
+
+}  // namespace BOARD_NAMESPACE
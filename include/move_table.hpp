@@ -0,0 +1,76 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Precomputed result of a player move on a single row or column.
+ * A line of LENGTH tiles is read starting from the edge the tiles move toward,
+ * and is keyed by packing each tile value in 4 bits: key = sum tile[k] << 4k.
+ * There are 16^LENGTH keys (65536 for a line of 4), each entry stores the
+ * line after sliding and merging and whether anything moved.
+ *
+ * Only tile values 0 to MAX_TILE can be looked up, callers fall back to
+ * State::player_move_legacy for larger tiles.
+ */
+template <int LENGTH>
+class LineMoveTable {
+public:
+    static constexpr int TILE_BITS = 4;
+    static constexpr int MAX_TILE = (1 << TILE_BITS) - 1;
+    static constexpr uint32_t KEYS = 1u << (TILE_BITS * LENGTH);
+
+    struct Entry {
+        // Note: merged tiles may reach MAX_TILE + 1, hence int8_t and not a nibble
+        std::array<int8_t, LENGTH> tiles;
+        // same line packed like the key, for PackedBoard (which cannot hold MAX_TILE + 1)
+        uint32_t packed;
+        bool moved;
+        // a merge produced MAX_TILE + 1, packed lost that tile
+        bool overflows;
+    };
+
+    LineMoveTable() : entries_(KEYS) {
+        for (uint32_t key = 0; key < KEYS; key++) {
+            std::array<int8_t, LENGTH> line;
+            for (int k = 0; k < LENGTH; k++) {
+                line[k] = static_cast<int8_t>((key >> (TILE_BITS * k)) & MAX_TILE);
+            }
+            entries_[key] = slide(line);
+        }
+    }
+
+    const Entry& operator[](uint32_t key) const { return entries_[key]; }
+
+    /**
+     * @brief Reference move of a single line toward index 0:
+     * non-zero tiles are compacted toward index 0 and equal neighbours are merged
+     * once, the tile closest to the edge having priority ([1, 1, 1] gives [2, 1, 0]).
+     */
+    static Entry slide(const std::array<int8_t, LENGTH>& line) {
+        Entry entry{};
+        int write = 0;
+        int8_t pending = 0;
+        for (int k = 0; k < LENGTH; k++) {
+            if (line[k] == 0) continue;
+            if (pending == line[k]) {
+                // merged tile cannot be merged again in the same turn
+                entry.tiles[write++] = static_cast<int8_t>(pending + 1);
+                pending = 0;
+            } else {
+                if (pending != 0) entry.tiles[write++] = pending;
+                pending = line[k];
+            }
+        }
+        if (pending != 0) entry.tiles[write++] = pending;
+        entry.moved = entry.tiles != line;
+        for (int k = 0; k < LENGTH; k++) {
+            entry.overflows |= entry.tiles[k] > MAX_TILE;
+            entry.packed |= static_cast<uint32_t>(entry.tiles[k] & MAX_TILE) << (TILE_BITS * k);
+        }
+        return entry;
+    }
+
+private:
+    std::vector<Entry> entries_;
+};
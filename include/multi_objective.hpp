@@ -0,0 +1,46 @@
+#pragma once
+#include "types.hpp"
+#include "utils.hpp"
+
+namespace BOARD_NAMESPACE {
+
+/*
+ * Solves every objective from first to last in a single backwards induction, over the
+ * boards of the last one. A board of a lower objective o is the same board in the larger
+ * space and has the same successors: only its final reward differs, 1 once a tile reaches o.
+ * The successors of a board are generated once per time step, and the backup of each
+ * objective reads them, one value lane per objective. Lanes of a board are contiguous,
+ * so each sum over successors updates every lane at once (vectorised by the compiler).
+ */
+struct ObjectiveLanes {
+    // Note: tiles are 4-bit, there are at most 15 objectives
+    static constexpr int MAX_LANES = 15;
+
+    int first = 0;
+    int last = 0;
+
+    int count() const { return last - first + 1; }
+    int lane(int objective) const { return objective - first; }
+    bool contains(int objective) const { return objective >= first && objective <= last; }
+};
+
+/**
+ * @brief optimal_policy of every objective of lanes, over the boards of index for lanes.last.
+ * policy, value and new_value have index.size() x lanes.count() entries, the lanes of a board
+ * next to each other: objective o of the board at position is entry position * lanes.count() + lanes.lane(o).
+ * Values of each lane are bit-identical to those of optimal_policy for its objective,
+ * on the boards that objective indexes. Instantiated for the indexes of optimal_policy.
+ * Supports threads, chunk_size, precompute_transitions and tolerance of options,
+ * throws std::invalid_argument for the others.
+ * @return number of time steps the values hold: T, unless the solve was interrupted
+ */
+template <typename Index>
+int optimal_policies(Table<action_type>& policy,
+                     Table<reward_type>& value,
+                     Table<reward_type>& new_value,
+                     ObjectiveLanes lanes,
+                     int T,
+                     const Index& index,
+                     const SolverOptions& options = SolverOptions());
+
+}  // namespace BOARD_NAMESPACE
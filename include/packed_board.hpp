@@ -0,0 +1,76 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+namespace BOARD_NAMESPACE {
+
+/**
+ * @brief Board stored as 4 bits per tile in a single 64-bit integer.
+ * Tile i (flat index r * COLS + c) lives in bits [4i, 4i + 4).
+ * Fits boards up to 4x4 and tiles up to 2^15.
+ *
+ * Indexing mimics std::array<int8_t, N>: reads return the tile value,
+ * writes go through TileReference so that state(i, j) = v and state(i, j)++
+ * keep working on the packed representation.
+ */
+class PackedBoard {
+public:
+    static constexpr int TILE_BITS = 4;
+    static constexpr int8_t MAX_TILE = (1 << TILE_BITS) - 1;
+    static constexpr int SIZE = BOARD_SIZE_ROWS * BOARD_SIZE_COLS;
+    static_assert(SIZE * TILE_BITS <= 64, "PackedBoard supports boards up to 16 tiles");
+
+    // Bit mask of the lowest bit of every tile of the board
+    static constexpr uint64_t LOW_BITS = (SIZE == 16) ? 0x1111111111111111ULL
+                                                      : (0x1111111111111111ULL & ((1ULL << (SIZE * TILE_BITS)) - 1));
+
+    class TileReference {
+    public:
+        TileReference(uint64_t& bits, int index) : bits_(bits), shift_(index * TILE_BITS) {}
+
+        operator int8_t() const { return static_cast<int8_t>((bits_ >> shift_) & MAX_TILE); }
+
+        TileReference& operator=(int8_t value) {
+            assert(value >= 0 && value <= MAX_TILE);
+            bits_ = (bits_ & ~(uint64_t(MAX_TILE) << shift_)) | (uint64_t(value & MAX_TILE) << shift_);
+            return *this;
+        }
+        TileReference& operator=(const TileReference& other) { return *this = int8_t(other); }
+
+        TileReference& operator++() { return *this = static_cast<int8_t>(int8_t(*this) + 1); }
+        int8_t operator++(int) {
+            int8_t previous = *this;
+            ++*this;
+            return previous;
+        }
+
+    private:
+        uint64_t& bits_;
+        int shift_;
+    };
+
+    constexpr PackedBoard() : bits_(0) {}
+
+    int8_t operator[](size_t i) const { return static_cast<int8_t>((bits_ >> (i * TILE_BITS)) & MAX_TILE); }
+    TileReference operator[](size_t i) { return TileReference(bits_, static_cast<int>(i)); }
+
+    uint64_t bits() const { return bits_; }
+    void set_bits(uint64_t bits) { bits_ = bits; }
+
+    /// @brief One bit (the lowest of the nibble) set for every empty tile
+    uint64_t empty_mask() const {
+        uint64_t occupied = bits_ | (bits_ >> 1);
+        occupied |= occupied >> 2;
+        return ~occupied & LOW_BITS;
+    }
+    int count_empty() const { return __builtin_popcountll(empty_mask()); }
+
+    friend bool operator==(const PackedBoard& a, const PackedBoard& b) { return a.bits_ == b.bits_; }
+    friend bool operator!=(const PackedBoard& a, const PackedBoard& b) { return a.bits_ != b.bits_; }
+
+private:
+    uint64_t bits_;
+};
+
+}  // namespace BOARD_NAMESPACE
@@ -0,0 +1,75 @@
+#pragma once
+#include "types.hpp"
+#include "utils.hpp"
+#include "transition_matrix.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace BOARD_NAMESPACE {
+
+/**
+ * @brief Boards that reach each board in one turn, the transposed TransitionMatrix.
+ * Compressed sparse row layout like the matrix: the predecessors of position are stored
+ * contiguously from offsets[position], each once, sorted by position, next to the length
+ * of the shortest block of the predecessor that holds position (the largest probability
+ * 1 / length of reaching it with a player move).
+ */
+class PredecessorIndex {
+public:
+    PredecessorIndex() = default;
+
+    /// @brief Inverts transitions, a count pass then a fill pass over every block
+    static PredecessorIndex build(const TransitionMatrix& transitions);
+
+    int64_t size() const { return static_cast<int64_t>(offsets_.size()) - 1; }
+    uint64_t total_predecessors() const { return predecessors_.size(); }
+    size_t memory_bytes() const;
+
+    int count(int64_t position) const { return static_cast<int>(offsets_[position + 1] - offsets_[position]); }
+    const transition_index_type* predecessors(int64_t position) const { return predecessors_.data() + offsets_[position]; }
+    const uint8_t* block_lengths(int64_t position) const { return block_lengths_.data() + offsets_[position]; }
+
+private:
+    std::vector<uint64_t> offsets_;
+    std::vector<transition_index_type> predecessors_;
+    std::vector<uint8_t> block_lengths_;
+};
+
+/// @brief Work of a prioritized solve, next to that of a full sweep of the same boards
+struct PrioritizedSweepReport {
+    // boards of the index, each backed up once by a full sweep
+    int64_t states = 0;
+    int64_t backups = 0;
+    int64_t predecessors = 0;
+    double seconds = 0;
+    // Note: false when interrupted, values are then below the fixed point
+    bool converged = false;
+
+    double full_sweeps() const { return states > 0 ? static_cast<double>(backups) / states : 0; }
+};
+
+/**
+ * @brief Solves the game to completion, like optimal_policy_to_completion, with asynchronous
+ * value iteration that only backs up boards whose successors changed.
+ * Values start at the final reward. A priority queue holds the boards to back up, by how much
+ * a change of a successor can move their value: the change times the probability of reaching
+ * that successor. Each backup writes value in place and queues the predecessors of the board
+ * (see PredecessorIndex) whose priority is above max(options.tolerance, 0). Winning boards
+ * seed the queue, and boards none of whose successors ever change are never backed up: they
+ * keep their final reward and their first valid move, what a backup would give them.
+ *
+ * With a tolerance of 0, values and policy are bit-identical to optimal_policy with tolerance 0
+ * run until it converges: every board is backed up after the last change of its successors,
+ * with the sums of bellman_backup in the same order. Backups run on one thread, the transition
+ * matrix is built on options.threads.
+ * policy and value have index.size() entries. Instantiated for the indexes of optimal_policy.
+ */
+template <typename Index>
+PrioritizedSweepReport optimal_policy_prioritized(Table<action_type>& policy,
+                                                  Table<reward_type>& value,
+                                                  int winning_objective,
+                                                  const Index& index,
+                                                  const SolverOptions& options = SolverOptions());
+
+}  // namespace BOARD_NAMESPACE
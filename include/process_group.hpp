@@ -0,0 +1,125 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+namespace util {
+
+/**
+ * @brief Anonymous shared memory mapping (mmap MAP_SHARED | MAP_ANONYMOUS).
+ * Processes forked after the mapping is created read and write the same pages,
+ * nothing is left behind in /dev/shm when the processes exit or crash.
+ * Pages are zero and only allocated when first touched, large mappings ask for huge pages.
+ */
+class SharedMemory {
+public:
+    SharedMemory() = default;
+    /// @throws std::runtime_error if the mapping fails
+    explicit SharedMemory(size_t bytes);
+    ~SharedMemory();
+
+    SharedMemory(SharedMemory&& other) noexcept;
+    SharedMemory& operator=(SharedMemory&& other) noexcept;
+    SharedMemory(const SharedMemory&) = delete;
+    SharedMemory& operator=(const SharedMemory&) = delete;
+
+    void* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    void* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+/// @brief CPUs a worker process is pinned to, and their NUMA node (-1 when the machine reports none)
+struct WorkerPlacement {
+    int node = -1;
+    std::vector<int> cpus;
+};
+
+/**
+ * @brief Placement of processes workers over the CPUs the calling process may run on.
+ * Workers go round robin over the NUMA nodes of these CPUs (all of them as one group without
+ * NUMA information), and the workers of a node split its CPUs into contiguous ranges.
+ */
+std::vector<WorkerPlacement> plan_worker_placement(int processes);
+/// @brief CPUs as a list of ranges, eg "0-3,8" and the node, for the logs
+std::string to_string(const WorkerPlacement& placement);
+
+/// @brief A worker process of a ProcessGroup exited or was killed during a step
+class WorkerFailure : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * @brief Worker processes forked from the calling process (the coordinator),
+ * which run one step of a task at a time and wait for each other at the end of it.
+ * Workers see the memory of the coordinator at the time of the fork (copy on write),
+ * and share SharedMemory mappings created before it.
+ *
+ * The barrier at the end of a step is kept by the coordinator, which polls a done
+ * counter per worker in shared memory and waitpid: a worker that dies is reported
+ * as a WorkerFailure instead of blocking the others forever, and the remaining
+ * workers are stopped. Workers die with the coordinator (PR_SET_PDEATHSIG),
+ * and ignore Ctrl+C: cancellation is up to the coordinator, between two steps.
+ * Each worker is pinned to the CPUs of plan_worker_placement, so that the pages it
+ * touches first land on its own node and its threads stay there.
+ */
+class ProcessGroup {
+public:
+    /**
+     * @brief Body of a step in worker process worker, for the argument given to run.
+     * progress can be increased as work is done, returns a value reported to the coordinator.
+     */
+    using Task = std::function<double(int worker, int64_t argument, std::atomic<int64_t>& progress)>;
+
+    /// @throws std::runtime_error if the processes cannot be forked
+    ProcessGroup(int processes, Task task);
+    /// @brief Stops the workers and waits for them
+    ~ProcessGroup();
+
+    ProcessGroup(const ProcessGroup&) = delete;
+    ProcessGroup& operator=(const ProcessGroup&) = delete;
+
+    int size() const { return static_cast<int>(workers_.size()); }
+    /// @brief Where each worker runs, by worker number
+    const std::vector<WorkerPlacement>& placement() const { return placement_; }
+
+    /**
+     * @brief Runs task(worker, argument) in every worker, returns when all are done.
+     * on_wait is called every poll_seconds while waiting, with the sum of the progress of the workers.
+     * @return the value returned by the task in each worker
+     * @throws WorkerFailure if a worker died, the group is then empty
+     */
+    std::vector<double> run(int64_t argument,
+                            const std::function<void(int64_t progress)>& on_wait = nullptr,
+                            double poll_seconds = 10);
+
+private:
+    struct Control;
+    struct alignas(64) Slot {
+        std::atomic<int64_t> done;
+        std::atomic<int64_t> progress;
+        double result;
+    };
+
+    [[noreturn]] void worker_main(int worker);
+    /// @brief Kills and reaps every worker still running
+    void stop_all(int signal);
+
+    Task task_;
+    SharedMemory shared_;
+    Control* control_ = nullptr;
+    Slot* slots_ = nullptr;
+    std::vector<pid_t> workers_;
+    std::vector<WorkerPlacement> placement_;
+    int64_t sequence_ = 0;
+};
+
+}
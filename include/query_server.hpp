@@ -0,0 +1,67 @@
+#pragma once
+#include "types.hpp"
+#include "state.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace BOARD_NAMESPACE {
+
+/*
+ * Headless policy queries, over a byte stream (stdin/stdout) or a Unix domain socket.
+ * Framing, in host byte order, with no text or delimiters:
+ *   request   uint32 count, then count boards of 8 bytes
+ *   response  count answers of 8 bytes, in the order of the boards
+ * A board is the 4 bits per tile layout of PackedBoard: tile i (row-major) holds
+ * the power of 2 in bits [4i, 4i+4), 0 for an empty tile.
+ * A count of 0, or the end of the stream, ends the session.
+ * Buffers are allocated once per session, answering a batch allocates nothing.
+ */
+
+struct QueryAnswer {
+    uint8_t action;  // action_type, Action::None when no move is possible
+    uint8_t reserved[3];
+    float value;     // win probability under the optimal policy
+};
+static_assert(sizeof(QueryAnswer) == 8, "QueryAnswer is sent as is");
+
+/// @brief Largest number of boards in one request, larger counts end the session
+constexpr uint32_t MAX_QUERY_BATCH = 1 << 16;
+
+/// @brief Answers count boards, called once per request
+using QueryLookup = std::function<void(const uint64_t* boards, QueryAnswer* answers, uint32_t count)>;
+
+/// @brief Hash of a board in the 4 bits per tile layout, same as gamestate_to_hash
+inline int64_t packed_board_hash(int winning_objective, uint64_t board) {
+    int64_t hash = 0;
+    for (int i = State::SIZE - 1; i >= 0; i--) {
+        const int64_t tile = (board >> (4 * i)) & 0xF;
+        // tiles above the objective are clamped, like gamestate_to_hash
+        hash = hash * (winning_objective + 1) + (tile > winning_objective ? winning_objective : tile);
+    }
+    return hash;
+}
+
+/// @brief Counters of a session or a server
+struct QueryStatistics {
+    uint64_t batches = 0;
+    uint64_t queries = 0;
+    double seconds = 0;
+};
+
+/**
+ * @brief Answers requests read from in_fd on out_fd until the session ends.
+ * Returns the statistics of the session.
+ */
+QueryStatistics serve_queries(int in_fd, int out_fd, const QueryLookup& lookup);
+
+/**
+ * @brief Listens on a Unix domain socket at path, every connection is a session
+ * served by its own thread. Runs until util::global_stop_requested, then removes
+ * the socket file. Throws std::runtime_error if the socket cannot be created.
+ * lookup must be safe to call from several threads at once.
+ */
+QueryStatistics serve_unix_socket(const std::string& path, const QueryLookup& lookup);
+
+}  // namespace BOARD_NAMESPACE
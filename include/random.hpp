@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+
+namespace util {
+
+/// @brief SplitMix64 step, spreads consecutive seeds over the whole 64-bit space
+inline uint64_t splitmix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief xoshiro256** pseudo random generator (Blackman and Vigna).
+ * 32 bytes of state, a few cycles per number and no shared state:
+ * each thread (or each independent stream of games) owns its generator.
+ * Not for cryptography.
+ */
+class Xoshiro256 {
+public:
+    explicit Xoshiro256(uint64_t seed) {
+        for (uint64_t& word : state_) {
+            word = splitmix64(seed);
+        }
+    }
+
+    uint64_t next() {
+        const uint64_t result = rotl(state_[1] * 5, 7) * 9;
+        const uint64_t t = state_[1] << 17;
+        state_[2] ^= state_[0];
+        state_[3] ^= state_[1];
+        state_[1] ^= state_[2];
+        state_[0] ^= state_[3];
+        state_[2] ^= t;
+        state_[3] = rotl(state_[3], 45);
+        return result;
+    }
+
+    /// @brief Uniform integer in [0, bound), bound > 0
+    /// Note: multiply-shift (Lemire), the bias is below 2^-32 for the bounds used here
+    uint32_t below(uint32_t bound) {
+        return static_cast<uint32_t>(((next() >> 32) * bound) >> 32);
+    }
+
+private:
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    uint64_t state_[4];
+};
+
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <cstddef>
+
+/**
+ * @brief Tuning knobs of the expectimax search played instead of solved tables (see expectimax.hpp).
+ */
+struct SearchOptions {
+    // wall time of a move, iterative deepening returns the deepest search done in time,
+    // 0 for no limit (then max_depth or the horizon bounds the search)
+    double seconds_per_move = 0.1;
+    // deepest search in player moves, 0 for no limit but the horizon
+    int max_depth = 0;
+    // chance branches whose probability from the root is lower are estimated instead of searched, 0 for none
+    double min_probability = 1e-4;
+    // threads searching the subtrees of the root, 0 for all hardware threads
+    int threads = 1;
+    // bytes of the transposition table, rounded down to a power of two entries
+    size_t table_bytes = size_t(64) << 20;
+};
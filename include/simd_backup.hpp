@@ -0,0 +1,63 @@
+#pragma once
+#include "types.hpp"
+
+#include <cstdint>
+#include <string>
+
+/*
+ * Bellman backups of consecutive states from a precomputed transition matrix,
+ * vectorised across states: each SIMD lane backs up its own state, in structure
+ * of arrays batches of 2 (SSE4.1), 4 (AVX2) or 8 (AVX-512) states.
+ * Lanes gather their successor values, weigh them by the probability of their block
+ * and sum them in the same order as the scalar backup, and the argmax over actions
+ * runs in registers: values are bit-identical to the scalar backup at every level.
+ * Instruction sets are picked at runtime, binaries still run on any x86-64 CPU
+ * (and on other architectures, with the scalar backup only).
+ * Note: the gathers are random accesses to the value table, when it does not fit
+ * in cache they cost as much as the scalar loads; Auto times every level
+ * on the first states of the table instead of assuming the widest is the fastest.
+ */
+
+/// @brief Runtime choice of backup instruction set, see --simd
+/// Note: levels are ordered, each one implies the narrower ones
+enum class SimdLevel : uint8_t {
+    Auto, Scalar, SSE4, AVX2, AVX512
+};
+
+/// @brief Name used on the command line
+std::string to_string(SimdLevel level);
+/// @throws std::invalid_argument for an unknown name
+SimdLevel parse_simd_level(const std::string& name);
+
+/// @brief Widest level this CPU (and operating system) supports
+SimdLevel detect_simd_level();
+bool simd_supported(SimdLevel level);
+/// @brief Auto becomes detect_simd_level()
+/// @throws std::invalid_argument if this CPU does not support level
+SimdLevel resolve_simd_level(SimdLevel level);
+
+/// @brief Compressed sparse row arrays of a TransitionMatrix (see transition_matrix.hpp)
+struct TransitionBlocks {
+    // Note: same as TransitionMatrix::PLAYER_ACTIONS, Up, Down, Left, Right
+    static constexpr int PLAYER_ACTIONS = 4;
+
+    const uint64_t* state_offsets = nullptr;
+    const uint8_t* action_lengths = nullptr;
+    const transition_index_type* successors = nullptr;
+};
+
+/**
+ * @brief Backs up the states at positions [begin, end) of the tables:
+ * writes new_value and policy of each from value, like bellman_backup_sparse.
+ * @param level a resolved level, ie not Auto and supported by this CPU
+ */
+void simd_bellman_backup(SimdLevel level, const TransitionBlocks& transitions, int64_t begin, int64_t end,
+                         const double* value, double* new_value, action_type* policy);
+
+/**
+ * @brief Backs up the states [begin, end) with every level this CPU supports,
+ * and returns the fastest. new_value and policy of these states are written like
+ * simd_bellman_backup, with the same values at every level.
+ */
+SimdLevel fastest_simd_level(const TransitionBlocks& transitions, int64_t begin, int64_t end,
+                             const double* value, double* new_value, action_type* policy);
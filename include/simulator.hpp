@@ -0,0 +1,51 @@
+#pragma once
+#include "types.hpp"
+#include "state.hpp"
+
+#include <cstdint>
+#include <functional>
+
+namespace BOARD_NAMESPACE {
+
+/**
+ * @brief Tuning knobs for simulate_games.
+ * Games are split in chunks of chunk_size, each with its own generator seeded
+ * from (seed, first game of the chunk): results only depend on seed and chunk_size,
+ * not on the number of threads.
+ */
+struct SimulationOptions {
+    int64_t games = 1000000;
+    uint64_t seed = 2048;
+    // Total number of threads, 0 for all hardware threads
+    int threads = 1;
+    int64_t chunk_size = 4096;
+    // Player turns per game, the time horizon of the solve, negative for no limit
+    int max_turns = -1;
+};
+
+struct SimulationResult {
+    int64_t games = 0;
+    int64_t wins = 0;
+    int64_t player_moves = 0;
+    double seconds = 0;
+
+    double win_rate() const { return games > 0 ? static_cast<double>(wins) / games : 0; }
+    /// @brief 95% Wilson score interval of the win probability
+    void confidence_interval(double& low, double& high) const;
+    double games_per_second() const { return seconds > 0 ? games / seconds : 0; }
+};
+
+/// @brief Action to play on a board at a turn (player moves made so far), called from several threads at once
+using PolicyFunction = std::function<action_type(const State& gamestate, int turn)>;
+
+/**
+ * @brief Plays games from the empty board: Nature places a tile, then the player
+ * moves following policy, until the objective is reached, the policy plays None,
+ * or max_turns player moves were made. A game is won if a tile reaches winning_objective,
+ * which is what the values of the solver estimate.
+ * Games do not allocate, boards stay on the stack and generators are per chunk.
+ */
+SimulationResult simulate_games(int winning_objective, const PolicyFunction& policy,
+                                const SimulationOptions& options);
+
+}  // namespace BOARD_NAMESPACE
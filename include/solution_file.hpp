@@ -0,0 +1,113 @@
+#pragma once
+#include "types.hpp"
+#include "value_storage.hpp"
+#include "table_allocator.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/*
+ * Solution file: the policy and value tables of a solve, written once and mapped
+ * read-only by later runs, so that several processes share the same page cache copy.
+ * Layout (host byte order, checked with byte_order):
+ *   SolutionHeader
+ *   policy   table_size action_type, at policy_offset
+ *   value    table_size entries of the header precision, at value_offset (64-byte aligned)
+ * Tables are indexed like the solve that wrote them: the header records whether
+ * only reachable boards and/or one board per symmetry orbit were stored.
+ * A solve of several objectives (see multi_objective.hpp) stores the entries of
+ * objectives first_objective to winning_objective of each board next to each other.
+ */
+struct SolutionHeader {
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+    char magic[8] = {'S', '2', '0', '4', '8', 'S', 'O', 'L'};
+    uint32_t version = VERSION;
+    uint32_t byte_order = BYTE_ORDER_MARK;
+    uint32_t rows = 0;
+    uint32_t cols = 0;
+    int32_t winning_objective = 0;
+    // time horizon of the values, COMPLETE for a solve to completion
+    int32_t horizon = 0;
+    uint8_t precision = 0;  // ValuePrecision
+    uint8_t reachable_only = 0;
+    uint8_t symmetry = 0;
+    // lowest objective of a solve of several objectives, 0 for a single objective
+    uint8_t first_objective = 0;
+    uint8_t reserved[4] = {};
+    // entries of each table, boards times objectives
+    uint64_t table_size = 0;
+    uint64_t policy_offset = 0;
+    uint64_t value_offset = 0;
+
+    static constexpr int32_t COMPLETE = -1;
+};
+static_assert(sizeof(SolutionHeader) == 64, "SolutionHeader is written as is");
+
+/**
+ * @brief Writes header and tables to path, through a temporary file renamed at the end
+ * so that readers never map a partial file. Fills the sizes and offsets of header.
+ * Throws std::runtime_error if the file cannot be written.
+ */
+template <typename Storage>
+void save_solution(const std::string& path, SolutionHeader header,
+                   const Table<action_type>& policy, const Table<Storage>& value);
+
+/**
+ * @brief Checkpoints of a running backwards induction, as solution files
+ * whose horizon is the number of time steps done so far (see SolverOptions::resume_steps).
+ */
+struct CheckpointOptions {
+    // checkpoint file, empty for no checkpoints
+    std::string path;
+    // minimum wall time between two checkpoints, one is always written when interrupted
+    double interval_seconds = 600;
+    // board size, objective and layout of the tables, horizon and precision are filled in
+    SolutionHeader header;
+};
+
+/**
+ * @brief Read-only memory mapping of a solution file.
+ * Opening validates the header against this build (board sizes) and the file size,
+ * and every policy entry (one byte per entry), and throws std::runtime_error otherwise.
+ * The value table is only paged in when read.
+ */
+class MappedSolution {
+public:
+    MappedSolution() = default;
+    ~MappedSolution();
+
+    MappedSolution(MappedSolution&& other) noexcept;
+    MappedSolution& operator=(MappedSolution&& other) noexcept;
+    MappedSolution(const MappedSolution&) = delete;
+    MappedSolution& operator=(const MappedSolution&) = delete;
+
+    static MappedSolution open(const std::string& path);
+
+    bool is_open() const { return data_ != nullptr; }
+    const SolutionHeader& header() const { return *static_cast<const SolutionHeader*>(data_); }
+    ValuePrecision precision() const { return static_cast<ValuePrecision>(header().precision); }
+
+    const action_type* policy() const {
+        return reinterpret_cast<const action_type*>(bytes() + header().policy_offset);
+    }
+    /// @brief Value table, throws std::runtime_error if Storage is not the precision of the file
+    template <typename Storage>
+    const Storage* values() const {
+        if (precision() != ValueStorage<Storage>::PRECISION) {
+            throw std::runtime_error("Solution file holds " + to_string(precision()) + " values, not "
+                                     + ValueStorage<Storage>::NAME);
+        }
+        return reinterpret_cast<const Storage*>(bytes() + header().value_offset);
+    }
+
+private:
+    const char* bytes() const { return static_cast<const char*>(data_); }
+    void unmap();
+
+    void* data_ = nullptr;
+    size_t length_ = 0;
+};
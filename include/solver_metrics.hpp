@@ -0,0 +1,66 @@
+#pragma once
+#include "types.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+/*
+ * Telemetry of the backwards induction, one JSON object per time step (JSON lines):
+ * counters are kept in locals of each chunk of a sweep and added to the step totals
+ * once per chunk, so that they stay on in Release builds (see --metrics).
+ */
+
+/// @brief Work done by the backups of a sweep, or of part of it
+struct SweepCounters {
+    // states backed up
+    int64_t states = 0;
+    // player moves that change the board, over all states and actions
+    int64_t valid_moves = 0;
+    // Nature successors whose value was read
+    int64_t successors = 0;
+    // states whose action differs from the previous time step
+    int64_t policy_changes = 0;
+
+    SweepCounters& operator+=(const SweepCounters& other) {
+        states += other.states;
+        valid_moves += other.valid_moves;
+        successors += other.successors;
+        policy_changes += other.policy_changes;
+        return *this;
+    }
+};
+
+/// @brief One line of the metrics file
+struct StepMetrics {
+    // time of the step, and number of steps done by this solve including it
+    int time = 0;
+    int step = 0;
+    double seconds = 0;
+    SweepCounters counters;
+    // largest change of a value, negative when not tracked (see SolverOptions::tolerance)
+    reward_type max_change = -1;
+    // peak resident set of the solver, and the largest of its worker processes (negative without workers)
+    int64_t peak_rss_bytes = 0;
+    int64_t worker_peak_rss_bytes = -1;
+};
+
+/// @brief Peak resident set size of the calling process (getrusage)
+int64_t peak_rss_bytes();
+
+/**
+ * @brief Appends StepMetrics to a JSON lines file, one flushed line per step
+ * so that dashboards can follow a running solve.
+ */
+class MetricsWriter {
+public:
+    /// @throws std::runtime_error if the file cannot be created
+    explicit MetricsWriter(const std::string& path);
+
+    /// @throws std::runtime_error if the line cannot be written
+    void write(const StepMetrics& metrics);
+
+private:
+    std::string path_;
+    std::ofstream out_;
+};
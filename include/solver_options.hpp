@@ -0,0 +1,44 @@
+#pragma once
+#include "types.hpp"
+#include "solution_file.hpp"
+#include "simd_backup.hpp"
+
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Tuning knobs for optimal_policy.
+ * Defaults reproduce the original single-threaded sweep.
+ */
+struct SolverOptions {
+    // Total number of threads for each time step sweep, 0 for all hardware threads
+    int threads = 1;
+    // Worker processes each sweeping a contiguous shard of the table on threads threads, 1 for no workers
+    // Note: tables live in shared memory, a worker that dies stops the solve at the last completed step
+    int processes = 1;
+    // Number of consecutive hashes handed to a thread at a time
+    // Note: small enough to balance states with many empty tiles, large enough to amortise the atomic
+    int64_t chunk_size = 4096;
+    // Build the TransitionMatrix once and run every time step as a sparse gather
+    // Note: trades memory (reported after the build) for not recomputing moves T times
+    bool precompute_transitions = false;
+    // Instruction set of the precomputed backups of double values, Auto for the fastest on this CPU
+    // Note: values are bit-identical at every level, see simd_backup.hpp
+    SimdLevel simd = SimdLevel::Auto;
+    // Stop once no value changes by more than tolerance in a sweep, negative to always run T sweeps
+    // Note: 0 stops exactly when values are fixed, later sweeps would not change anything
+    reward_type tolerance = -1;
+    // Update value in place instead of swapping with new_value (which may then be empty)
+    // Note: converges to the same values in fewer sweeps, but mixes time steps and runs on one thread
+    bool gauss_seidel = false;
+    // Time steps that value and policy already hold when the solve starts, 0 starts from the final reward
+    // Note: rewards do not depend on time, so k more steps extend a horizon T solution to T+k
+    int resume_steps = 0;
+    // Periodic checkpoints of the tables, and one when interrupted
+    CheckpointOptions checkpoint;
+    // Time policy file the policy of every time step is written to, empty to only keep the last one
+    // Note: written in the background while the next step is swept, see time_policy.hpp
+    std::string time_policy_path;
+    // JSON lines file of per time step telemetry, empty for none (see solver_metrics.hpp)
+    std::string metrics_path;
+};
@@ -1,5 +1,6 @@
 #pragma once
 #include "types.hpp"
+#include "random.hpp"
 #include <cstdint>
 #include <assert.h>
 #include <optional>
@@ -7,6 +8,35 @@
 
 #include <random> // for rand
 
+/*
+ * Board code is compiled once per board size of BOARD_SIZES (see CMakeLists.txt),
+ * with BOARD_SIZE_ROWS, BOARD_SIZE_COLS and BOARD_NAMESPACE = board_<rows>x<cols>
+ * defined for each: every size keeps compile-time dimensions and its own symbols,
+ * and main picks one at runtime (see board_sizes.hpp.in).
+ */
+#if !defined(BOARD_SIZE_ROWS) || !defined(BOARD_SIZE_COLS) || !defined(BOARD_NAMESPACE)
+#error "Board sources are compiled per board size, with BOARD_SIZE_ROWS, BOARD_SIZE_COLS and BOARD_NAMESPACE"
+#endif
+
+#ifdef PACKED_STATE
+// 4 bits per tile in a single integer, see packed_board.hpp (configure with -DPACKED_STATE=ON)
+#include "packed_board.hpp"
+#endif
+
+namespace BOARD_NAMESPACE {
+
+// Legacy implementation:
+// typedef std::vector<std::vector<int8_t>> state_type;
+// New implementation:
+// tile_reference is what State(i, j) returns for writing a tile
+#ifdef PACKED_STATE
+typedef PackedBoard state_type;
+typedef PackedBoard::TileReference tile_reference;
+#else
+typedef std::array<int8_t, BOARD_SIZE_ROWS * BOARD_SIZE_COLS> state_type;
+typedef int8_t& tile_reference;
+#endif
+
 class State {
 public:
     // Dimensions are part of the type's definition, not the object's instance
@@ -17,7 +47,7 @@ public:
     state_type data_;
 
     int8_t operator()(int r, int c) const;
-    int8_t& operator()(int r, int c);
+    tile_reference operator()(int r, int c);
     friend bool operator==(const State& s1, const State& s2);
 
     State();
@@ -25,8 +55,14 @@ public:
     State(const std::vector<std::vector<int8_t>>& data);
 
     std::optional<State> player_move(action_type a) const;
+    // Legacy implementation of player_move with shifting functions,
+    // kept as the reference the lookup tables are tested against
+    std::optional<State> player_move_legacy(action_type a) const;
     std::vector<Coord> all_nature_moves() const;
+    int count_empty_tiles() const;
     std::optional<State> random_nature_move() const;
+    // Same distribution, drawn from the caller's generator: reproducible and thread-safe
+    std::optional<State> random_nature_move(util::Xoshiro256& generator) const;
     friend inline void hash_to_gamestate(int winning_objective, const int64_t hash, State& gamestate);
     friend inline int64_t gamestate_to_hash(int winning_objective, const State& gamestate);
 
@@ -39,4 +75,6 @@ private:
 };
 
 // Outside of class
-std::ostream& operator<<(std::ostream& os, const State& s);
\ No newline at end of file
+std::ostream& operator<<(std::ostream& os, const State& s);
+
+}  // namespace BOARD_NAMESPACE
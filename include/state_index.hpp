@@ -0,0 +1,187 @@
+#pragma once
+#include "types.hpp"
+#include "thread_pool.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace BOARD_NAMESPACE {
+
+/*
+ * State indexes map board hashes (see gamestate_to_hash) to positions
+ * in the policy and value tables, and back:
+ *   size()         number of table entries
+ *   hash_at(i)     hash of the board stored at position i
+ *   position(hash) position of a board, only valid for boards in the index
+ * Positions are increasing with hashes, so the empty board is always at 0.
+ * The solver is written once against this interface.
+ */
+
+/// @brief Every base-(winning_objective+1) number is a table entry
+class DenseIndex {
+public:
+    explicit DenseIndex(int64_t total_combinations) : size_(total_combinations) {}
+
+    int64_t size() const { return size_; }
+    int64_t hash_at(int64_t position) const { return position; }
+    int64_t position(int64_t hash) const { return hash; }
+
+private:
+    int64_t size_;
+};
+
+/**
+ * @brief Bitset over all hashes with constant time rank:
+ * rank(hash) is the number of set hashes below hash,
+ * a per-word prefix count plus a popcount. Costs 1/4 byte per hash.
+ */
+class RankedBitset {
+public:
+    RankedBitset() = default;
+    /// @brief Takes the bits of total hashes (64 per word) and builds the rank directory
+    RankedBitset(int64_t total, std::vector<uint64_t> bits);
+
+    int64_t total() const { return total_; }
+    int64_t count() const { return static_cast<int64_t>(word_ranks_.back()); }
+    int64_t rank(int64_t hash) const {
+        uint64_t word = hash >> 6;
+        uint64_t below = bits_[word] & ((uint64_t(1) << (hash & 63)) - 1);
+        return static_cast<int64_t>(word_ranks_[word]) + __builtin_popcountll(below);
+    }
+    bool test(int64_t hash) const {
+        return hash >= 0 && hash < total_ && ((bits_[hash >> 6] >> (hash & 63)) & 1);
+    }
+
+    /// @brief Set hashes in increasing order, ie the inverse of rank
+    std::vector<int64_t> set_hashes(util::ThreadPool& pool) const;
+
+    size_t memory_bytes() const;
+
+private:
+    int64_t total_ = 0;
+    std::vector<uint64_t> bits_;
+    // number of set hashes before each word of bits_
+    std::vector<uint64_t> word_ranks_ = {0};
+};
+
+/**
+ * @brief Only the boards reachable from the empty board get a table entry.
+ * Built by a parallel breadth-first search over Nature and player moves.
+ * Membership is a RankedBitset over all hashes, position(hash) is its rank
+ * and hash_at is a sorted list.
+ * Memory is 1/4 byte per hash plus 8 bytes per reachable board,
+ * instead of 17 bytes per hash for the dense value, new_value and policy tables.
+ */
+class ReachableIndex {
+public:
+    ReachableIndex() = default;
+
+    static ReachableIndex build(int winning_objective, util::ThreadPool& pool);
+
+    int64_t size() const { return static_cast<int64_t>(hashes_.size()); }
+    int64_t hash_at(int64_t position) const { return hashes_[position]; }
+    int64_t position(int64_t hash) const { return members_.rank(hash); }
+    bool contains(int64_t hash) const { return members_.test(hash); }
+
+    int64_t total_combinations() const { return members_.total(); }
+    size_t memory_bytes() const;
+
+private:
+    RankedBitset members_;
+    // reachable hashes in increasing order
+    std::vector<int64_t> hashes_;
+};
+
+/**
+ * @brief Same boards and positions as ReachableIndex, for state spaces too large for its bitset.
+ * Hashes are split in SHARDS ranges, each an open addressing hash table:
+ * the breadth-first search inserts under a per-shard lock, then every shard is sorted
+ * on its own and rebuilt as a read-only table of (hash, position) entries,
+ * so that solver threads look positions up without locks.
+ * Memory is 40 to 72 bytes per reachable board, independent of the number of hashes:
+ * smaller than ReachableIndex once fewer than about 1 in 200 hashes are reachable.
+ */
+class SparseIndex {
+public:
+    SparseIndex() = default;
+
+    static SparseIndex build(int winning_objective, util::ThreadPool& pool);
+
+    int64_t size() const { return static_cast<int64_t>(hashes_.size()); }
+    int64_t hash_at(int64_t position) const { return hashes_[position]; }
+    /// @brief size() for boards outside the index
+    int64_t position(int64_t hash) const {
+        if (hash < 0 || hash >= total_combinations_) return size();
+        const Shard& shard = shards_[hash >> shard_shift_];
+        if (shard.entries.empty()) return size();
+        for (uint64_t slot = slot_of(hash) & shard.mask;; slot = (slot + 1) & shard.mask) {
+            const Entry& entry = shard.entries[slot];
+            if (entry.hash == hash) return entry.position;
+            if (entry.hash == EMPTY) return size();
+        }
+    }
+    bool contains(int64_t hash) const { return position(hash) < size(); }
+
+    int64_t total_combinations() const { return total_combinations_; }
+    size_t memory_bytes() const;
+
+    // Note: a power of two, enough ranges that the search rarely waits on a shard lock
+    static constexpr int64_t SHARDS = 4096;
+
+private:
+    static constexpr int64_t EMPTY = -1;
+    struct Entry {
+        int64_t hash;
+        int64_t position;
+    };
+    // tables are at most half full, capacity and mask are a power of two (minus one)
+    struct Shard {
+        std::vector<Entry> entries;
+        uint64_t mask = 0;
+    };
+
+    /// @brief Rebuilds shard with capacity slots (a power of two)
+    static void resize(Shard& shard, size_t capacity);
+    /// @brief Mixes the hash so that consecutive boards land on distant slots
+    static uint64_t slot_of(int64_t hash) {
+        uint64_t z = static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ULL;
+        return z ^ (z >> 29);
+    }
+
+    int64_t total_combinations_ = 0;
+    // shard of a hash is hash >> shard_shift_, shards are increasing ranges of hashes
+    int shard_shift_ = 0;
+    std::vector<Shard> shards_;
+    // reachable hashes in increasing order
+    std::vector<int64_t> hashes_;
+};
+
+/**
+ * @brief One table entry per symmetry orbit (see symmetry.hpp), for its canonical board.
+ * position(hash) canonicalises the board first, so that every board of an orbit
+ * shares the value of its canonical board. Policy entries are actions on the
+ * canonical board: map them back with apply(inverse(symmetry), action).
+ * Optionally restricted to reachable boards, which are closed under symmetries.
+ */
+class SymmetricIndex {
+public:
+    SymmetricIndex() = default;
+
+    static SymmetricIndex build(int winning_objective, util::ThreadPool& pool,
+                                const ReachableIndex* reachable = nullptr);
+
+    int64_t size() const { return static_cast<int64_t>(hashes_.size()); }
+    int64_t hash_at(int64_t position) const { return hashes_[position]; }
+    int64_t position(int64_t hash) const;
+
+    int64_t total_combinations() const { return members_.total(); }
+    size_t memory_bytes() const;
+
+private:
+    int winning_objective_ = 0;
+    // canonical boards
+    RankedBitset members_;
+    std::vector<int64_t> hashes_;
+};
+
+}  // namespace BOARD_NAMESPACE
@@ -0,0 +1,117 @@
+#pragma once
+#include "types.hpp"
+#include "state.hpp"
+#include "utils.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+
+namespace BOARD_NAMESPACE {
+
+/**
+ * @brief Successors of boards computed on hashes rather than on decoded boards.
+ * The hash of tile i weighs it by the place value (winning_objective+1)^i, so:
+ * - consecutive hashes are an odometer increment of the board, amortised O(1)
+ *   instead of a division and a modulo per tile (see hash_to_gamestate),
+ * - a 2 or a 4 on an empty tile i of an afterstate adds 1 or 2 place values
+ *   to the afterstate hash, instead of hashing a copy of the board per Nature move.
+ * Only the afterstate of each player move is hashed. Successors come in the order of
+ * the Bellman sweep: empty tiles in row-major order, the 2 then the 4 on each.
+ * Holds the current board, one kernel per thread.
+ */
+class SuccessorKernel {
+public:
+    /// @brief At most a 2 and a 4 on every tile
+    static constexpr int MAX_SUCCESSORS = 2 * State::SIZE;
+
+    explicit SuccessorKernel(int winning_objective) : winning_objective_(winning_objective) {
+        int64_t place_value = 1;
+        for (int i = 0; i < State::SIZE; i++) {
+            place_values_[i] = place_value;
+            place_value *= winning_objective + 1;
+        }
+        // Note: with an objective of 1, a 4 is clamped to the objective like in gamestate_to_hash
+        tile_2_ = std::min(1, winning_objective);
+        tile_4_ = std::min(2, winning_objective);
+    }
+
+    /// @brief Board of hash: an odometer step if hash follows the previous one, a full decode otherwise
+    const State& seek(int64_t hash) {
+        if (hash == hash_ + 1 && hash_ >= 0) {
+            increment();
+        } else {
+            hash_to_gamestate(winning_objective_, hash, gamestate_);
+            for (int i = 0; i < State::SIZE; i++) {
+                digits_[i] = gamestate_(i / State::COLS, i % State::COLS);
+            }
+        }
+        hash_ = hash;
+        return gamestate_;
+    }
+
+    int64_t hash() const { return hash_; }
+    const State& gamestate() const { return gamestate_; }
+    int64_t place_value(int tile) const { return place_values_[tile]; }
+
+    /**
+     * @brief Writes the hashes of the boards Nature can produce after afterstate,
+     * whose hash is afterstate_hash, to out (at least MAX_SUCCESSORS entries)
+     * @return number of successors, 0 on a full board
+     */
+    int nature_successors(const State& afterstate, int64_t afterstate_hash, int64_t* out) const {
+        int successors = 0;
+#ifdef PACKED_STATE
+        uint64_t empty = afterstate.data_.empty_mask();
+        while (empty != 0) {
+            const int i = __builtin_ctzll(empty) / PackedBoard::TILE_BITS;
+            out[successors++] = afterstate_hash + tile_2_ * place_values_[i];
+            out[successors++] = afterstate_hash + tile_4_ * place_values_[i];
+            empty &= empty - 1;
+        }
+#else
+        for (int i = 0; i < State::SIZE; i++) {
+            if (afterstate.data_[i] != 0) continue;
+            out[successors++] = afterstate_hash + tile_2_ * place_values_[i];
+            out[successors++] = afterstate_hash + tile_4_ * place_values_[i];
+        }
+#endif
+        return successors;
+    }
+
+    /**
+     * @brief Writes the hashes of the successors of the current board after action a to out
+     * @return number of successors, 0 for an invalid move
+     */
+    int successors(action_type a, int64_t* out) const {
+        std::optional<State> next_state = gamestate_.player_move(a);
+        if (!next_state.has_value()) {
+            return 0;
+        }
+        return nature_successors(next_state.value(), gamestate_to_hash(winning_objective_, next_state.value()), out);
+    }
+
+private:
+    void increment() {
+        int i = 0;
+        // Note: never runs past the last tile, the caller only steps to hashes of the board
+        while (digits_[i] == winning_objective_) {
+            digits_[i] = 0;
+            gamestate_(i / State::COLS, i % State::COLS) = 0;
+            i++;
+        }
+        digits_[i]++;
+        gamestate_(i / State::COLS, i % State::COLS) = digits_[i];
+    }
+
+    int winning_objective_;
+    int64_t tile_2_;
+    int64_t tile_4_;
+    int64_t place_values_[State::SIZE];
+    // current board, hash_ is -1 before the first seek
+    int64_t hash_ = -1;
+    State gamestate_;
+    int8_t digits_[State::SIZE];
+};
+
+}  // namespace BOARD_NAMESPACE
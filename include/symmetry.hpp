@@ -0,0 +1,48 @@
+#pragma once
+#include "types.hpp"
+#include "state.hpp"
+
+#include <array>
+#include <cstdint>
+
+namespace BOARD_NAMESPACE {
+
+/*
+ * Board symmetries: the game is invariant under these transformations,
+ * as long as the player action is transformed the same way.
+ * Rectangular boards have the first 4, square boards all 8.
+ * Each symmetry maps tile (r, c) to the destination given in the comment.
+ */
+enum class Symmetry : uint8_t {
+    Identity,       // (r, c)
+    FlipRows,       // (ROWS-1-r, c), mirror top and bottom
+    FlipColumns,    // (r, COLS-1-c), mirror left and right
+    Rotate180,      // (ROWS-1-r, COLS-1-c)
+    Transpose,      // (c, r), square boards only
+    AntiTranspose,  // (n-1-c, n-1-r), square boards only
+    Rotate90,       // (c, n-1-r), clockwise, square boards only
+    Rotate270       // (n-1-c, r), square boards only
+};
+
+namespace Symmetries {
+    inline constexpr int COUNT = (State::ROWS == State::COLS) ? 8 : 4;
+}
+
+Symmetry inverse(Symmetry g);
+
+/// @brief Board after applying g
+State apply(Symmetry g, const State& gamestate);
+/// @brief Action that moves tiles in the direction a moves them, once the board is transformed by g
+action_type apply(Symmetry g, action_type a);
+
+/// @brief Representative of a symmetry orbit, the board with the smallest hash
+struct CanonicalBoard {
+    int64_t hash;
+    // canonical board = apply(symmetry, board)
+    Symmetry symmetry;
+};
+
+CanonicalBoard canonical_hash(int winning_objective, int64_t hash);
+CanonicalBoard canonical_hash(int winning_objective, const State& gamestate);
+
+}  // namespace BOARD_NAMESPACE
@@ -0,0 +1,115 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace util {
+
+/*
+ * Allocator of the policy and value tables. The sweeps look up successors all over
+ * the value table, with 4 KiB pages nearly every lookup misses the TLB: large tables
+ * are mapped on 2 MiB pages instead, and their pages are first touched in parallel,
+ * one contiguous block per thread, so that on a NUMA machine the pages of each block
+ * land on the node of the thread that touched it instead of all on the allocating one.
+ * Note: the sweeps hand out chunks dynamically, blocks spread the table over the nodes
+ * of the threads rather than pinning each chunk to the node that will read it.
+ */
+
+/// @brief Runtime choice of table pages, see --huge-pages
+enum class HugePages : uint8_t {
+    // explicit pages when some are reserved, else transparent ones
+    Auto,
+    // MAP_HUGETLB, from the pool of /proc/sys/vm/nr_hugepages
+    Explicit,
+    // madvise(MADV_HUGEPAGE), the kernel backs the table with huge pages when it can
+    Transparent,
+    // 4 KiB pages only (MADV_NOHUGEPAGE), for comparisons
+    Off
+};
+
+/// @brief Name used on the command line
+std::string to_string(HugePages pages);
+/// @throws std::invalid_argument for an unknown name
+HugePages parse_huge_pages(const std::string& name);
+
+struct TableOptions {
+    HugePages huge_pages = HugePages::Auto;
+    // threads of the first touch, 0 for all hardware threads
+    int threads = 0;
+};
+
+// Tables smaller than a huge page come from calloc
+constexpr size_t HUGE_PAGE_BYTES = size_t(2) << 20;
+
+/// @brief Maps a table of bytes and first touches it, see TableAllocator. The table is zeroed.
+/// @throws std::bad_alloc if it cannot be mapped
+void* allocate_table(size_t bytes, const TableOptions& options);
+void free_table(void* data, size_t bytes);
+/// @brief Gives the pages of a table back to the kernel, its entries read as zero until written again.
+/// Tables smaller than a huge page keep their memory.
+void release_table_pages(void* data, size_t bytes);
+
+/// @brief Pages backing a table, as reported by the kernel after the first touch
+struct TablePlacement {
+    size_t bytes = 0;
+    // bytes on explicit or transparent huge pages
+    size_t huge_bytes = 0;
+    bool explicit_huge_pages = false;
+    // bytes per NUMA node of the pages this process has touched, empty when the kernel does not report it
+    std::vector<std::pair<int, size_t>> node_bytes;
+};
+
+/// @brief Reads /proc/self/smaps and /proc/self/numa_maps for the mappings of [data, data + bytes)
+TablePlacement table_placement(const void* data, size_t bytes);
+std::string to_string(const TablePlacement& placement);
+
+/**
+ * @brief std::allocator replacement for the tables, see allocate_table.
+ * Allocators compare equal: any of them frees a table of any other.
+ * Tables of n entries start at zero without a serial pass over them: the pages are zeroed
+ * by the first touch on every thread, so entries are default-initialised instead.
+ * Note: a table resized down and up again keeps its old entries past the smaller size.
+ */
+template <typename T>
+class TableAllocator {
+public:
+    using value_type = T;
+
+    TableAllocator() = default;
+    explicit TableAllocator(const TableOptions& options) : options_(options) {}
+    template <typename U>
+    TableAllocator(const TableAllocator<U>& other) : options_(other.options()) {}
+
+    T* allocate(size_t n) {
+        if (n > SIZE_MAX / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        return static_cast<T*>(allocate_table(n * sizeof(T), options_));
+    }
+    void deallocate(T* data, size_t n) { free_table(data, n * sizeof(T)); }
+
+    template <typename U>
+    void construct(U* entry) noexcept(std::is_nothrow_default_constructible_v<U>) {
+        ::new (static_cast<void*>(entry)) U;
+    }
+
+    const TableOptions& options() const { return options_; }
+
+    template <typename U>
+    bool operator==(const TableAllocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const TableAllocator<U>&) const { return false; }
+
+private:
+    TableOptions options_;
+};
+
+}
+
+/// @brief Policy and value tables of the solver, see util::TableAllocator
+template <typename T>
+using Table = std::vector<T, util::TableAllocator<T>>;
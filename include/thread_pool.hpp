@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace util {
+
+/**
+ * @brief Fixed-size pool of worker threads used by the solver sweeps.
+ * Work is handed out as chunks of a half-open range [begin, end):
+ * every thread (including the caller) pulls the next chunk from a shared
+ * atomic counter until the range is exhausted. Chunks with cheap states
+ * finish fast and the thread simply grabs another one, which balances
+ * the uneven per-state cost without any explicit scheduling.
+ */
+class ThreadPool {
+public:
+    // Body of a parallel loop, called once per chunk [chunk_begin, chunk_end)
+    using ChunkFunction = std::function<void(int64_t chunk_begin, int64_t chunk_end)>;
+
+    /// @param threads total number of threads, including the calling thread.
+    ///        0 selects std::thread::hardware_concurrency()
+    explicit ThreadPool(int threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /// @brief Runs body over [begin, end) in chunks of chunk_size, blocks until done
+    void parallel_for(int64_t begin, int64_t end, int64_t chunk_size, const ChunkFunction& body);
+
+    int size() const { return static_cast<int>(workers_.size()) + 1; }
+
+    /// @brief Number of threads used when the user asks for 0 (auto)
+    static int default_threads();
+
+private:
+    void worker_loop();
+    void run_chunks();
+
+    std::vector<std::thread> workers_;
+
+    std::mutex mutex_;
+    std::condition_variable work_ready_;
+    std::condition_variable work_done_;
+
+    // current job, only valid while a parallel_for is running
+    const ChunkFunction* body_ = nullptr;
+    int64_t end_ = 0;
+    int64_t chunk_size_ = 1;
+    std::atomic<int64_t> next_chunk_{0};
+
+    // generation_ is bumped for each job so sleeping workers know there is new work
+    uint64_t generation_ = 0;
+    int busy_workers_ = 0;
+    bool shutting_down_ = false;
+};
+
+}
@@ -0,0 +1,150 @@
+#pragma once
+#include "types.hpp"
+#include "table_allocator.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * Time policy file: the policy of every time step of a solve, pi_t for t = first_time
+ * down to first_time - steps + 1, where time t leaves T - t player moves to the horizon.
+ * The policy table of a step is cut in blocks of block_entries positions, and each block
+ * is stored packed at 3 bits per action (21 actions per 64-bit word). Consecutive steps
+ * mostly pick the same actions: a block equal to the same block of the previous step
+ * is not stored again, the directory points to the stored copy. The action at (t, position)
+ * is one directory entry and one word away, whatever the number of steps.
+ * Layout (host byte order, checked with byte_order):
+ *   TimePolicyHeader
+ *   blocks      block_count packed blocks, at blocks_offset
+ *   directory   steps x blocks of the table uint32_t block numbers, at directory_offset
+ */
+struct TimePolicyHeader {
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+    static constexpr int ACTION_BITS = 3;
+    static constexpr int ACTIONS_PER_WORD = 64 / ACTION_BITS;
+
+    char magic[8] = {'S', '2', '0', '4', '8', 'T', 'P', 'I'};
+    uint32_t version = VERSION;
+    uint32_t byte_order = BYTE_ORDER_MARK;
+    uint64_t table_size = 0;
+    uint32_t block_entries = 0;
+    // time of the first step written, the following ones are first_time - 1, first_time - 2...
+    int32_t first_time = 0;
+    int32_t steps = 0;
+    uint32_t block_count = 0;
+    uint64_t blocks_offset = 0;
+    uint64_t directory_offset = 0;
+    uint8_t reserved[8] = {};
+
+    int64_t table_blocks() const { return (table_size + block_entries - 1) / block_entries; }
+    int64_t block_words() const { return (block_entries + ACTIONS_PER_WORD - 1) / ACTIONS_PER_WORD; }
+};
+static_assert(sizeof(TimePolicyHeader) == 64, "TimePolicyHeader is written as is");
+
+/**
+ * @brief Writes the policy of each time step of a solve to a time policy file,
+ * on a background thread: add_step copies the table and returns, comparing,
+ * packing and writing it overlap with the sweep of the next time step.
+ * The file is written to a temporary path, renamed by finish.
+ */
+class TimePolicyWriter {
+public:
+    // Note: a multiple of 64 positions, so that blocks also line up with cache lines of the policy table
+    static constexpr uint32_t BLOCK_ENTRIES = 4096;
+
+    /// @brief The copies of the policy are tables allocated with table_options
+    /// @throws std::runtime_error if the file cannot be created
+    TimePolicyWriter(const std::string& path, int64_t table_size, int first_time,
+                     const util::TableOptions& table_options = util::TableOptions());
+    /// @brief Abandons an unfinished file, the temporary file is removed
+    ~TimePolicyWriter();
+
+    TimePolicyWriter(const TimePolicyWriter&) = delete;
+    TimePolicyWriter& operator=(const TimePolicyWriter&) = delete;
+
+    /**
+     * @brief Queues the policy of the next time step, waits while the previous one is being written.
+     * @throws std::runtime_error if writing an earlier step failed
+     */
+    void add_step(const action_type* policy);
+
+    /// @brief Writes the queued steps and the directory, and renames the file to path
+    /// @throws std::runtime_error if the file cannot be written
+    void finish();
+
+    /// @brief Steps written so far, valid after finish
+    const TimePolicyHeader& header() const { return header_; }
+
+private:
+    void writer_loop();
+    void write_step();
+
+    std::string path_;
+    std::string temporary_path_;
+    std::ofstream out_;
+    TimePolicyHeader header_;
+    std::vector<uint32_t> directory_;
+    std::vector<uint64_t> words_;
+
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    // the step being written, and the one before it
+    Table<action_type> pending_;
+    Table<action_type> previous_;
+    bool has_pending_ = false;
+    bool closing_ = false;
+    std::string error_;
+};
+
+/**
+ * @brief Read-only memory mapping of a time policy file.
+ * Opening validates the header and the file size, and throws std::runtime_error otherwise.
+ */
+class MappedTimePolicy {
+public:
+    MappedTimePolicy() = default;
+    ~MappedTimePolicy();
+
+    MappedTimePolicy(MappedTimePolicy&& other) noexcept;
+    MappedTimePolicy& operator=(MappedTimePolicy&& other) noexcept;
+    MappedTimePolicy(const MappedTimePolicy&) = delete;
+    MappedTimePolicy& operator=(const MappedTimePolicy&) = delete;
+
+    static MappedTimePolicy open(const std::string& path);
+
+    bool is_open() const { return data_ != nullptr; }
+    const TimePolicyHeader& header() const { return *static_cast<const TimePolicyHeader*>(data_); }
+
+    /**
+     * @brief Action of pi_time at position of the policy table.
+     * Times after first_time use the first step, times before the last step use the last one:
+     * the same policy when the solve converged, only the closest one when it was interrupted.
+     */
+    action_type action(int time, int64_t position) const {
+        const TimePolicyHeader& h = header();
+        int64_t step = static_cast<int64_t>(h.first_time) - time;
+        step = step < 0 ? 0 : (step >= h.steps ? h.steps - 1 : step);
+        const int64_t block = position / h.block_entries;
+        const int64_t entry = position % h.block_entries;
+        const uint32_t stored = directory()[step * h.table_blocks() + block];
+        const uint64_t word = blocks()[stored * h.block_words() + entry / TimePolicyHeader::ACTIONS_PER_WORD];
+        const int shift = TimePolicyHeader::ACTION_BITS * (entry % TimePolicyHeader::ACTIONS_PER_WORD);
+        return static_cast<action_type>((word >> shift) & ((1u << TimePolicyHeader::ACTION_BITS) - 1));
+    }
+
+private:
+    const char* bytes() const { return static_cast<const char*>(data_); }
+    const uint64_t* blocks() const { return reinterpret_cast<const uint64_t*>(bytes() + header().blocks_offset); }
+    const uint32_t* directory() const { return reinterpret_cast<const uint32_t*>(bytes() + header().directory_offset); }
+    void unmap();
+
+    void* data_ = nullptr;
+    size_t length_ = 0;
+};
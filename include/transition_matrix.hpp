@@ -0,0 +1,61 @@
+#pragma once
+#include "types.hpp"
+#include "state.hpp"
+#include "thread_pool.hpp"
+#include "state_index.hpp"
+#include "simd_backup.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace BOARD_NAMESPACE {
+
+/**
+ * @brief Successors of every (state, player action) pair, built once per solve.
+ * States and successors are table positions of a state index (see state_index.hpp),
+ * ie hashes for a DenseIndex.
+ * Compressed sparse row layout: the successors of state h are stored contiguously
+ * starting at state_offsets[h], one block per action in Actions::All order
+ * (Up, Down, Left, Right). Each block lists, for every empty tile after the
+ * player move, the hash with a 2 then the hash with a 4 on that tile.
+ *
+ * Transition probabilities are uniform within a block (1 / block length), so only
+ * the block lengths are stored, as one byte per (state, action).
+ * A block length of 0 marks an invalid player move.
+ */
+class TransitionMatrix {
+public:
+    // Player actions with successors, Action::None is the identity and is not stored
+    static constexpr int PLAYER_ACTIONS = TransitionBlocks::PLAYER_ACTIONS;
+
+    TransitionMatrix() = default;
+
+    /// @brief Enumerates all transitions of the states in index for winning_objective
+    /// @throws std::length_error if a position does not fit in transition_index_type
+    template <typename Index>
+    static TransitionMatrix build(int winning_objective, const Index& index, util::ThreadPool& pool);
+
+    int64_t size() const { return static_cast<int64_t>(state_offsets_.size()) - 1; }
+    uint64_t total_successors() const { return successors_.size(); }
+    size_t memory_bytes() const;
+
+    /// @brief Number of successors of (hashed_state, action), 0 if the move is invalid
+    int block_length(int64_t hashed_state, int action) const {
+        return action_lengths_[hashed_state * PLAYER_ACTIONS + action];
+    }
+    /// @brief Pointer to the successors of hashed_state, blocks of all actions follow each other
+    const transition_index_type* successors(int64_t hashed_state) const {
+        return successors_.data() + state_offsets_[hashed_state];
+    }
+    /// @brief The arrays of the matrix, for the vectorised backups
+    TransitionBlocks blocks() const {
+        return {state_offsets_.data(), action_lengths_.data(), successors_.data()};
+    }
+
+private:
+    std::vector<uint64_t> state_offsets_;
+    std::vector<uint8_t> action_lengths_;
+    std::vector<transition_index_type> successors_;
+};
+
+}  // namespace BOARD_NAMESPACE
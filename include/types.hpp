@@ -29,15 +29,14 @@ inline std::ostream& operator<<(std::ostream& os, action_type action) {
     }
 }
 
-// Legacy implementation:
-// typedef std::vector<std::vector<int8_t>> state_type;
-// New implementation:
-typedef std::array<int8_t, BOARD_SIZE_ROWS * BOARD_SIZE_COLS> state_type;
-
 // Switch this between precisions for minor speed improvements,
 // and sizable memory usage reduction
 typedef double reward_type;
 
+// Hash type stored for every successor in the precomputed transition matrix
+// Switch to uint64_t for state spaces above 2^32 states, at twice the memory cost
+typedef uint32_t transition_index_type;
+
 struct Coord {
     int i;
     int j;
@@ -2,12 +2,19 @@
 
 #include "types.hpp"
 #include "state.hpp"
+#include "state_index.hpp"
+#include "value_storage.hpp"
+#include "solution_file.hpp"
+#include "solver_options.hpp"
+#include "table_allocator.hpp"
 
 #include <cstdint>
 #include <vector>
 
-reward_type final_reward(int8_t goal, const state_type& gamestate);
-reward_type r(int t, state_type s, action_type a);
+namespace BOARD_NAMESPACE {
+
+reward_type final_reward(int8_t goal, const State& gamestate);
+reward_type r(int t, State s, action_type a);
 
 void print_gamestate(const State& gamestate);
 void print_move(action_type a);
@@ -18,6 +25,16 @@ void print_move(action_type a);
 /// @param gamestate gamestate is modified in place to match the hash 
 inline void hash_to_gamestate(int winning_objective, const int64_t hash, State& gamestate) {
     int64_t hash_copy = hash;
+#ifdef PACKED_STATE
+    // assemble the nibbles in a register and store the board once
+    uint64_t bits = 0;
+    for (int i = 0; i < State::SIZE; i++)
+    {
+        bits |= static_cast<uint64_t>(hash_copy%(winning_objective+1)) << (PackedBoard::TILE_BITS * i);
+        hash_copy = hash_copy / (winning_objective+1) ;
+    }
+    gamestate.data_.set_bits(bits);
+#else
     for (int i = 0; i < State::SIZE; i++)
     {
         // checks 0 to winning_objective int that corresponds to i, j
@@ -25,6 +42,7 @@ inline void hash_to_gamestate(int winning_objective, const int64_t hash, State&
         // shifts the "bits"
         hash_copy = hash_copy / (winning_objective+1) ;
     }
+#endif
 }
 
 /**
@@ -35,18 +53,27 @@ inline void hash_to_gamestate(int winning_objective, const int64_t hash, State&
  * @param winning_objective The target tile value (as an exponent).
  * @param gamestate The current board configuration to hash.
  * @return int64_t The unique hash, or 0 if any tile exceeds the winning_objective.
- * * @note This assumes the total state space fits within a 64-bit integer.
+ * * @note This assumes the total state space fits within a 64-bit integer,
+ * which state_space_size checks. Boards reachable in a larger space are
+ * stored sparsely (see SparseIndex), hashes themselves stay 64-bit.
  */
 inline int64_t gamestate_to_hash(int winning_objective, const State& gamestate) {
     // TODO: FUTURE: when state_type will be a flat array,
     // we can directly iterate over it instead of using gamestate(i, j)
-    // TODO: FUTURE: support larger state spaces by using a larger integer type
     int64_t hash = 0;
+#ifdef PACKED_STATE
+    const uint64_t bits = gamestate.data_.bits();
+#endif
     for (int i = State::SIZE-1; i >= 0; i--)
     {
+#ifdef PACKED_STATE
+        const int8_t tile = static_cast<int8_t>((bits >> (PackedBoard::TILE_BITS * i)) & PackedBoard::MAX_TILE);
+#else
+        const int8_t tile = gamestate.data_[i];
+#endif
         // shifts the bits of the bitmask, does nothing for hash=0
         hash *= (winning_objective+1);
-        if (gamestate.data_[i] > winning_objective) {
+        if (tile > winning_objective) {
             // We treat all exceeding values as winning objectives
             // Note: this is an edge case but helps reduce risk of
             // evaluating overacheiving as invalid
@@ -56,14 +83,48 @@ inline int64_t gamestate_to_hash(int winning_objective, const State& gamestate)
             // This is also beneficial for logic and heuristics that use the sum of all tiles
             hash += winning_objective;
         } else {
-            hash += gamestate.data_[i];
+            hash += tile;
         }
     }
     return hash;
 }
 
-void optimal_policy(std::vector<action_type>& policy,
-				   std::vector<reward_type>& value,
-				   std::vector<reward_type>& new_value,
+/// @brief Worst-case number of turns needed to reach winning_objective on this board
+int default_time_horizon(int winning_objective);
+
+/**
+ * @brief Number of hashes of this board, (winning_objective+1)^SIZE.
+ * Throws std::overflow_error when they do not fit in int64_t, ie when
+ * gamestate_to_hash would overflow.
+ */
+int64_t state_space_size(int winning_objective);
+
+/// @return number of time steps the values hold: T, unless the solve was interrupted
+int optimal_policy(Table<action_type>& policy,
+				   Table<reward_type>& value,
+				   Table<reward_type>& new_value,
 				   int winning_objective,
-				   int T);
+				   int T,
+				   const SolverOptions& options = SolverOptions());
+
+/**
+ * @brief Backwards induction over the boards of a state index (see state_index.hpp).
+ * policy, value and new_value are indexed by index.position(hash) and have index.size() entries.
+ * Instantiated for:
+ * - DenseIndex: same as the overload above
+ * - ReachableIndex: values of reachable boards are identical to the dense optimal_policy
+ * - SparseIndex: same tables as ReachableIndex, for state spaces too large for its bitset
+ * - SymmetricIndex: one entry per symmetry orbit, policy is relative to the canonical board
+ * and for value tables of double, float, Fixed16 and Quantized8 (see value_storage.hpp).
+ * Backups accumulate in reward_type, each stored value is rounded once per time step.
+ */
+template <typename Index, typename Storage>
+int optimal_policy(Table<action_type>& policy,
+				   Table<Storage>& value,
+				   Table<Storage>& new_value,
+				   int winning_objective,
+				   int T,
+				   const Index& index,
+				   const SolverOptions& options = SolverOptions());
+
+}  // namespace BOARD_NAMESPACE
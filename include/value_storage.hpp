@@ -0,0 +1,87 @@
+#pragma once
+#include "types.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+
+/*
+ * Entries of the value tables. Values are win probabilities in [0, 1],
+ * so they can be stored with far fewer bits than a reward_type.
+ * The solver is templated on the entry type, ValueStorage<Storage> converts
+ * to and from reward_type: Bellman sums are always accumulated in reward_type
+ * and only the stored result of a backup is rounded.
+ */
+
+/// @brief Runtime choice of value table entries, see --precision
+enum class ValuePrecision : uint8_t {
+    Double, Float, Fixed16, Quantized8
+};
+
+/// @brief Probability p stored as round(p * 65535), 2 bytes
+struct Fixed16 {
+    uint16_t raw = 0;
+};
+
+/// @brief Probability p stored as round(p * 255), 1 byte
+struct Quantized8 {
+    uint8_t raw = 0;
+};
+
+template <typename Storage>
+struct ValueStorage;
+
+template <>
+struct ValueStorage<double> {
+    static constexpr const char* NAME = "double";
+    static constexpr ValuePrecision PRECISION = ValuePrecision::Double;
+    static reward_type decode(double stored) { return stored; }
+    static double encode(reward_type value) { return value; }
+};
+
+template <>
+struct ValueStorage<float> {
+    static constexpr const char* NAME = "float";
+    static constexpr ValuePrecision PRECISION = ValuePrecision::Float;
+    static reward_type decode(float stored) { return stored; }
+    static float encode(reward_type value) { return static_cast<float>(value); }
+};
+
+// Fixed point probabilities, rounded to the nearest step of 1/(2^BITS - 1)
+template <typename Fixed, typename Raw>
+struct FixedPointStorage {
+    static constexpr reward_type SCALE = static_cast<reward_type>((uint32_t(1) << (8 * sizeof(Raw))) - 1);
+    static reward_type decode(Fixed stored) { return stored.raw / SCALE; }
+    static Fixed encode(reward_type value) {
+        // Note: only the -1 sentinel of invalid moves is out of range, it is never stored
+        return Fixed{static_cast<Raw>(std::lround(std::clamp<reward_type>(value, 0, 1) * SCALE))};
+    }
+};
+
+template <>
+struct ValueStorage<Fixed16> : FixedPointStorage<Fixed16, uint16_t> {
+    static constexpr const char* NAME = "fixed16";
+    static constexpr ValuePrecision PRECISION = ValuePrecision::Fixed16;
+};
+
+template <>
+struct ValueStorage<Quantized8> : FixedPointStorage<Quantized8, uint8_t> {
+    static constexpr const char* NAME = "quant8";
+    static constexpr ValuePrecision PRECISION = ValuePrecision::Quantized8;
+};
+
+template <typename Storage>
+inline reward_type decode_value(Storage stored) { return ValueStorage<Storage>::decode(stored); }
+
+template <typename Storage>
+inline Storage encode_value(reward_type value) { return ValueStorage<Storage>::encode(value); }
+
+/// @brief Name used on the command line, ie ValueStorage<Storage>::NAME
+std::string to_string(ValuePrecision precision);
+
+/// @brief Inverse of to_string, throws std::invalid_argument on unknown names
+ValuePrecision parse_value_precision(const std::string& name);
+
+/// @brief Bytes per value table entry
+size_t value_bytes(ValuePrecision precision);
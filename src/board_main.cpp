@@ -0,0 +1,657 @@
+#include "types.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <bitset>
+
+#include <cassert>
+#include <chrono>
+#include <stdexcept>
+#include <type_traits>
+#include <algorithm>
+#include <memory>
+
+#include <unistd.h>
+
+#include "state.hpp"
+#include "utils.hpp"
+#include "test_state.hpp"
+#include "interrupt_handler.hpp"
+#include "cli.hpp"
+#include "state_index.hpp"
+#include "thread_pool.hpp"
+#include "symmetry.hpp"
+#include "completion_solver.hpp"
+#include "prioritized_sweeping.hpp"
+#include "value_storage.hpp"
+#include "solution_file.hpp"
+#include "query_server.hpp"
+#include "simulator.hpp"
+#include "time_policy.hpp"
+#include "multi_objective.hpp"
+#include "expectimax.hpp"
+
+namespace BOARD_NAMESPACE {
+
+// 2048 lite
+/******************/
+/* IN THIS MODEL: */
+/******************/
+// statespace is a grid of 2x3 of integers 0 and 1 to 5 representing 0 and 2^1 to 2^5
+
+// action is either
+// Up: swipe up ie "compact" blocks upward until impact on top edge while prioritising top 2 blocks in case of 3 similar blocks
+// Down: same but down
+// Left: same but right
+// Right: same but left
+// Note: action is illegal if no "movement" or "fusion" occurs
+
+// Offhand idea 1: maybe illegal moves are actually legal but give a penalty and use a finite turn ?
+// Or just uses a finite turn, but wouldn't that be bad for optimisation with duplicate states...
+// Conclusion: I don't think this is an actual concern, just make the move do nothing.
+
+// Complications: if action is illegal probability of transition is 0? - note: this seems irrelevant
+// Solution: instead of enumerating all unlikely scenarios and then noticing their transition is 0, enumerate "neighbour" situations using
+// a function that enumerates all empty squares after a move.
+
+// Other note: the game can be seen as guaranteed actions followed by probabilistic Nature's turns
+// Idea: introduce Nature as a "player" - ie list all empty squares after move
+
+// Idea 2: use pointers and a structure that can be traced back ? starting from a state,
+// eg empty board, list all possible nature moves, each corresponding to a state with an optimal move.
+// BUT: to find this optimal move, you need to come from the "ending"
+
+// Define endings function: all states with no more player moves (no "movement" or "fusion" possible in all 4 directions, ie kind of like no)
+// Good ending: ending that contains one (2 is not possible in 2x3) 32=2^5 square
+// Idea 3: start from ending states, and point to all possible Nature moves by finding 2=2^1 and 4=2^2 squares
+
+// Offhand idea 2: If we want a simpler test, make the goal variable and start less far from the end.
+
+
+// State class sketchout
+
+// Header of the solution and checkpoint files written with these options
+static SolutionHeader solution_header(const CliOptions& options) {
+    SolutionHeader header;
+    header.rows = State::ROWS;
+    header.cols = State::COLS;
+    header.winning_objective = options.winning_objective;
+    header.horizon = options.solve_to_completion ? SolutionHeader::COMPLETE : options.T;
+    header.reachable_only = options.reachable_only;
+    header.symmetry = options.symmetry;
+    header.first_objective = static_cast<uint8_t>(options.first_objective);
+    return header;
+}
+
+// Horizon of an interrupted prioritized solve, whose values are below those of any time step
+static constexpr int INTERRUPTED_COMPLETION = -2;
+
+/*
+ * Solves with value tables of Storage entries over the index selected by options,
+ * then plays the game with the optimal policy
+ */
+template <typename Storage>
+static int solve_and_play(const CliOptions& options, const ReachableIndex& reachable,
+                          const SparseIndex& sparse, const SymmetricIndex& symmetric,
+                          int64_t table_size, const MappedSolution& loaded) {
+    int8_t winning_objective = options.winning_objective;
+    int T = options.T;
+
+    // tables of several objectives hold an entry per objective of each board, the game plays one of them
+    const ObjectiveLanes objectives{options.first_objective > 0 ? options.first_objective : winning_objective,
+                                    winning_objective};
+    const int target = options.target_objective > 0 ? options.target_objective : winning_objective;
+    const int64_t table_entries = table_size * objectives.count();
+
+    // position of a board in the policy and value tables, and back
+    auto table_position = [&](int64_t hash) {
+        if (options.symmetry) return symmetric.position(hash);
+        if (options.sparse) return sparse.position(hash);
+        return options.reachable_only ? reachable.position(hash) : hash;
+    };
+    auto table_hash = [&](int64_t position) {
+        if (options.symmetry) return symmetric.hash_at(position);
+        if (options.sparse) return sparse.hash_at(position);
+        return options.reachable_only ? reachable.hash_at(position) : position;
+    };
+    // entry of the target objective of a board
+    auto table_entry = [&](int64_t hash) {
+        return table_position(hash) * objectives.count() + objectives.lane(target);
+    };
+
+    if (loaded.is_open() && static_cast<int64_t>(loaded.header().table_size) != table_entries) {
+        std::cerr << "Solution file has " << loaded.header().table_size << " entries, expected "
+                  << table_entries << std::endl;
+        return 1;
+    }
+
+    // with --search, moves come from an expectimax search of each board and nothing is solved
+    std::unique_ptr<ExpectimaxSearch> search;
+    if (options.search) {
+        SearchOptions search_options = options.search_options;
+        search_options.threads = options.solver.threads;
+        search = std::make_unique<ExpectimaxSearch>(winning_objective, search_options);
+        std::cout << "Search= " << 1000 * search_options.seconds_per_move << " ms per move, depth "
+                  << (search_options.max_depth > 0 ? std::to_string(search_options.max_depth) : "up to the horizon")
+                  << ", cut-off " << search_options.min_probability << ", table of " << search->table_entries()
+                  << " entries" << std::endl;
+    }
+    // moves left to the horizon at turn, what the search looks ahead for
+    auto moves_left = [&](int turn) { return std::max(0, T - turn); };
+
+    // empty policy that will be filled with policy_t, nothing is allocated for a loaded solution
+    const bool resuming = options.solver.resume_steps > 0;
+    const bool solving = !search && (!loaded.is_open() || resuming);
+    // Note: large tables are placed by the threads of the sweeps, on huge pages (see table_allocator.hpp)
+    const util::TableOptions table_options{options.huge_pages, options.solver.threads};
+    Table<action_type> policy(solving ? table_entries : 0, util::TableAllocator<action_type>(table_options));
+    Table<Storage> value(solving ? table_entries : 0, util::TableAllocator<Storage>(table_options));
+    // used for storing newly calculated values, the layered solve, in place updates
+    // and the sharded solve (which has its own tables in shared memory) do not need it
+    bool needs_new_value = solving && !options.solve_to_completion && !options.solver.gauss_seidel
+                           && options.solver.processes == 1;
+    Table<Storage> new_value(needs_new_value ? table_entries : 0, util::TableAllocator<Storage>(table_options));
+    if (solving) {
+        std::cout << "Value table= " << util::to_string(util::table_placement(value.data(), value.size() * sizeof(Storage)))
+                  << ", policy= " << util::to_string(util::table_placement(policy.data(), policy.size())) << std::endl;
+    }
+    if (resuming) {
+        std::copy_n(loaded.policy(), table_entries, policy.begin());
+        std::copy_n(loaded.values<Storage>(), table_entries, value.begin());
+    }
+
+    // tables the game is played with: the vectors above, or the pages of the solution file
+    const action_type* policy_table = policy.data();
+    const Storage* value_table = value.data();
+
+    // policy of each turn, from the time policy file written by the solve or given with --load
+    MappedTimePolicy time_policy;
+
+    // policy entries of symmetric tables are actions on the canonical board
+    // Note: without a time policy, every turn plays the policy of the last time step
+    auto table_action = [&](int64_t hash, int turn) {
+        const action_type action = time_policy.is_open() ? time_policy.action(turn, table_position(hash))
+                                                         : policy_table[table_entry(hash)];
+        if (!options.symmetry) return action;
+        CanonicalBoard canonical = canonical_hash(winning_objective, hash);
+        return apply(inverse(canonical.symmetry), action);
+    };
+
+    // Note: generic so that the precision error can be measured against double tables
+    // returns the horizon of the values, see SolutionHeader
+    auto solve = [&](Table<action_type>& policy, auto& value, auto& new_value, const SolverOptions& solver) {
+        if constexpr (std::is_same_v<std::decay_t<decltype(value)>, Table<reward_type>>) {
+            if (objectives.count() > 1) {
+                if (options.symmetry) {
+                    return optimal_policies(policy, value, new_value, objectives, T, symmetric, solver);
+                } else if (options.sparse) {
+                    return optimal_policies(policy, value, new_value, objectives, T, sparse, solver);
+                } else if (options.reachable_only) {
+                    return optimal_policies(policy, value, new_value, objectives, T, reachable, solver);
+                }
+                return optimal_policies(policy, value, new_value, objectives, T, DenseIndex(table_size), solver);
+            }
+            // Note: values are double, see --precision in parse_cli
+            if (options.prioritized_sweeping) {
+                PrioritizedSweepReport report;
+                if (options.symmetry) {
+                    report = optimal_policy_prioritized(policy, value, winning_objective, symmetric, solver);
+                } else if (options.sparse) {
+                    report = optimal_policy_prioritized(policy, value, winning_objective, sparse, solver);
+                } else if (options.reachable_only) {
+                    report = optimal_policy_prioritized(policy, value, winning_objective, reachable, solver);
+                } else {
+                    report = optimal_policy_prioritized(policy, value, winning_objective, DenseIndex(table_size), solver);
+                }
+                return report.converged ? SolutionHeader::COMPLETE : INTERRUPTED_COMPLETION;
+            }
+        }
+        if (options.solve_to_completion) {
+            if (options.symmetry) {
+                optimal_policy_to_completion(policy, value, winning_objective, symmetric, solver);
+            } else if (options.sparse) {
+                optimal_policy_to_completion(policy, value, winning_objective, sparse, solver);
+            } else if (options.reachable_only) {
+                optimal_policy_to_completion(policy, value, winning_objective, reachable, solver);
+            } else {
+                optimal_policy_to_completion(policy, value, winning_objective, DenseIndex(table_size), solver);
+            }
+            return SolutionHeader::COMPLETE;
+        } else if (options.symmetry) {
+            return optimal_policy(policy, value, new_value, winning_objective, T, symmetric, solver);
+        } else if (options.sparse) {
+            return optimal_policy(policy, value, new_value, winning_objective, T, sparse, solver);
+        } else if (options.reachable_only) {
+            return optimal_policy(policy, value, new_value, winning_objective, T, reachable, solver);
+        } else {
+            return optimal_policy(policy, value, new_value, winning_objective, T, DenseIndex(table_size), solver);
+        }
+    };
+
+    // time steps in the values, fewer than T when the solve was interrupted
+    int horizon = T;
+    if (search) {
+        // nothing to solve or load
+    } else if (!solving) {
+        policy_table = loaded.policy();
+        value_table = loaded.values<Storage>();
+    } else {
+        auto start = std::chrono::high_resolution_clock::now();
+        horizon = solve(policy, value, new_value, options.solver);
+        auto stop = std::chrono::high_resolution_clock::now();
+
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
+
+        std::cout << "Execution time= " << duration.count()*pow(10,-6) << "s" << std::endl;
+
+        if (horizon == INTERRUPTED_COMPLETION && !options.save_path.empty()) {
+            std::cerr << "Interrupted prioritized solve, not saved to " << options.save_path << std::endl;
+        } else if (!options.save_path.empty()) {
+            // Note: an interrupted solve is saved with the time steps it completed
+            SolutionHeader header = solution_header(options);
+            header.horizon = horizon;
+            try {
+                save_solution(options.save_path, header, policy, value);
+                std::cout << "Solution saved to " << options.save_path << std::endl;
+            } catch (const std::runtime_error& e) {
+                std::cerr << e.what() << std::endl;
+            }
+        }
+
+        // worst-case error of the rounded tables, against the same solve in double
+        if (options.precision_error && !std::is_same_v<Storage, reward_type>) {
+            std::cout << "Solving again with double values for the precision error..." << std::endl;
+            Table<action_type> reference_policy(table_size, util::TableAllocator<action_type>(table_options));
+            Table<reward_type> reference_value(table_size, util::TableAllocator<reward_type>(table_options));
+            Table<reward_type> reference_new_value(needs_new_value ? table_size : 0,
+                                                   util::TableAllocator<reward_type>(table_options));
+            SolverOptions reference_solver = options.solver;
+            reference_solver.resume_steps = 0;
+            reference_solver.checkpoint.path.clear();
+            reference_solver.time_policy_path.clear();
+            reference_solver.metrics_path.clear();
+            solve(reference_policy, reference_value, reference_new_value, reference_solver);
+
+            reward_type worst_error = 0;
+            int64_t worst_position = 0;
+            int64_t policy_differences = 0;
+            for (int64_t position = 0; position < table_size; position++) {
+                reward_type error = std::abs(decode_value(value[position]) - reference_value[position]);
+                if (error > worst_error) {
+                    worst_error = error;
+                    worst_position = position;
+                }
+                policy_differences += policy[position] != reference_policy[position];
+            }
+            std::cout << "Precision error= " << worst_error << " (board " << table_hash(worst_position)
+                      << "), policy differs on " << policy_differences << " of " << table_size
+                      << " boards (ties included)" << std::endl;
+        }
+    }
+
+    if (!options.solver.time_policy_path.empty()) {
+        try {
+            time_policy = MappedTimePolicy::open(options.solver.time_policy_path);
+            if (static_cast<int64_t>(time_policy.header().table_size) != table_size) {
+                throw std::runtime_error("Time policy file has " + std::to_string(time_policy.header().table_size)
+                                         + " boards, expected " + std::to_string(table_size));
+            }
+            std::cout << "Playing the policy of each turn from " << options.solver.time_policy_path << " ("
+                      << time_policy.header().steps << " time steps)" << std::endl;
+            // Note: a converged solve stops early with fewer steps than its horizon, whose last policy holds for every earlier time
+            const int last_time = time_policy.header().first_time - time_policy.header().steps + 1;
+            if (last_time > 0 && time_policy.header().steps >= horizon) {
+                std::cerr << "Warning: the solve was interrupted, turns before " << last_time
+                          << " play the policy of turn " << last_time << " instead of their own" << std::endl;
+            }
+        } catch (const std::runtime_error& e) {
+            std::cerr << e.what() << std::endl;
+            // Note: the solve already reported why the file is missing, its last policy is still good
+            if (!solving) {
+                return 1;
+            }
+            time_policy = MappedTimePolicy();
+        }
+    }
+
+    // headless: validate the policy on simulated games instead of playing
+    if (options.simulate_games > 0) {
+        SimulationOptions simulation;
+        simulation.games = options.simulate_games;
+        simulation.seed = options.seed;
+        // Note: the search already runs on the threads, games are played one at a time
+        simulation.threads = search ? 1 : options.solver.threads;
+        simulation.max_turns = options.solve_to_completion ? -1 : T;
+        // Note: boards are hashed for the winning objective, games are won once they reach the target
+        PolicyFunction play = [&](const State& gamestate, int turn) {
+            if (search) {
+                return search->search(gamestate, moves_left(turn)).action;
+            }
+            return table_action(gamestate_to_hash(winning_objective, gamestate), turn);
+        };
+
+        // the value of a game is the average over the first Nature move
+        reward_type start_value = 0;
+        std::vector<Coord> first_moves = State().all_nature_moves();
+        for (const Coord& tile : first_moves) {
+            if (search) break;
+            for (int8_t power : {int8_t(1), int8_t(2)}) {
+                State first_board;
+                first_board(tile.i, tile.j) = power;
+                int64_t hash = gamestate_to_hash(winning_objective, first_board);
+                start_value += decode_value(value_table[table_entry(hash)]) / (2.0 * first_moves.size());
+            }
+        }
+
+        std::cout << "Simulating " << simulation.games << " games..." << std::endl;
+        SimulationResult result = simulate_games(target, play, simulation);
+        double low = 0;
+        double high = 0;
+        result.confidence_interval(low, high);
+        std::cout << "Win rate= " << result.win_rate() << " (" << result.wins << " of " << result.games
+                  << "), 95% confidence interval [" << low << ", " << high << "]" << std::endl;
+        if (search) {
+            std::cout << "Search= " << to_string(search->statistics()) << std::endl;
+        } else {
+            std::cout << "Start value= " << start_value
+                      << (start_value >= low && start_value <= high ? " (inside the interval)" : " (outside the interval)")
+                      << std::endl;
+        }
+        std::cout << "Simulation time= " << result.seconds << "s, " << result.games_per_second() << " games/s, "
+                  << result.player_moves / std::max(result.seconds, 1e-9) << " moves/s" << std::endl;
+        return 0;
+    }
+
+    // headless: answer board queries instead of playing
+    if (options.serve || !options.socket_path.empty()) {
+        // boards outside of reachable tables get Action::None and a value of -1
+        QueryLookup lookup = [&](const uint64_t* boards, QueryAnswer* answers, uint32_t count) {
+            for (uint32_t k = 0; k < count; k++) {
+                const int64_t hash = packed_board_hash(winning_objective, boards[k]);
+                QueryAnswer& answer = answers[k];
+                answer = QueryAnswer{static_cast<uint8_t>(Action::None), {}, -1.0f};
+                const bool stored = options.sparse ? sparse.contains(hash)
+                                                   : !options.reachable_only || reachable.contains(hash);
+                if (!stored) continue;
+                // Note: queries carry no turn, answers are those of the first turn
+                answer.action = static_cast<uint8_t>(table_action(hash, 0));
+                answer.value = static_cast<float>(decode_value(value_table[table_entry(hash)]));
+            }
+        };
+
+        QueryStatistics statistics;
+        try {
+            if (!options.socket_path.empty()) {
+                std::cout << "Serving queries on " << options.socket_path << " until Ctrl+C..." << std::endl;
+                statistics = serve_unix_socket(options.socket_path, lookup);
+            } else {
+                std::cout << "Serving queries on stdin/stdout..." << std::endl;
+                statistics = serve_queries(STDIN_FILENO, STDOUT_FILENO, lookup);
+            }
+        } catch (const std::runtime_error& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        std::cout << "Queries= " << statistics.queries << " in " << statistics.batches << " batches, "
+                  << statistics.queries / std::max(statistics.seconds, 1e-9) << " queries/s" << std::endl;
+        return 0;
+    }
+
+    // a game simulation with Nature player
+    // it can be played by user or by optimal player, computed above
+
+    bool interactive_game = true;
+    if (interactive_game) {
+
+        while (true){ //play until user quits
+        std::cout << "To play, use w, a, s and d as directions Up, Left, Down, Right\n";
+        std::cout << "Enter to start: ";
+        std::getchar();
+
+        // initialise to empty game
+        
+        State gamestate = State();
+        
+        action_type optimal = Action::Up;
+        // player moves made so far, the time step of the policy
+        int turn = 0;
+        
+        // at each iteration make Nature move
+
+        do {
+            auto nature_move = gamestate.random_nature_move();
+            if (nature_move.has_value()) {
+                gamestate = nature_move.value();
+            } else {
+                // Note: this case is impossible to reach
+                std::cout << "No more nature moves possible, game ends." << std::endl;
+                break; // no more nature moves possible, game ends
+            }
+
+            print_gamestate(gamestate);
+            if (search) {
+                const SearchResult result = search->search(gamestate, moves_left(turn));
+                std::cout << "Value= " << result.value << " (depth " << result.depth << ", " << result.nodes
+                          << " nodes in " << result.seconds << "s)" << std::endl;
+                optimal = result.action;
+            } else {
+                int64_t hash = gamestate_to_hash(winning_objective,gamestate);
+                std::cout << "Value= " << decode_value(value_table[table_entry(hash)]) << std::endl;
+                optimal = table_action(hash, turn);
+            }
+            std::cout << "Optimal policy= ";
+            print_move(optimal);
+
+            action_type a = Action::None;
+            std::optional<State> next_state = std::nullopt;
+            // player_move returns true if move was successful and false if move is invalid
+            if (optimal!=Action::None) {
+                
+                do
+                {
+                    char input;
+                    std::cin >> input;
+                    switch (input)
+                    {
+                    case 'w':
+                        a=Action::Up;
+                        break;
+                    case 'a':
+                        a=Action::Left;
+                        break;
+                    case 's':
+                        a=Action::Down;
+                        break;
+                    case 'd':
+                        a=Action::Right;
+                        break;
+                    
+                    default:
+                        a=Action::None;
+                        break;
+                    }
+                    next_state = gamestate.player_move(a);
+                }
+                while (next_state.has_value()==false); // repeat until valid move is entered
+            }
+            if (next_state.has_value()) {
+                gamestate = next_state.value();
+                turn++;
+            } else {
+                std::cout << "No more player moves possible, game ends." << std::endl;
+                break; // no more player moves possible, game ends
+            }
+        }
+        while (optimal!=Action::None); // optimal policy is None when no move is possible
+        
+        const reward_type reward = search ? final_reward(winning_objective, gamestate)
+                                          : decode_value(value_table[table_entry(gamestate_to_hash(winning_objective,gamestate))]);
+        std::cout << "\nGame End.\nReward= " << reward << "\n" << std::endl;
+
+        // while (random_nature_move(gamestate) && optimal!=Action::None); // DEBUG: uncomment for testing gamestates
+        }
+    }
+
+    std::cout << "Hello World" << std::endl;
+    return 0;
+}
+
+
+/*
+ * Solver for this board size, called by main with the command line options
+ * and the solution file they name (not open when there is none)
+ */
+int board_main(CliOptions options, const MappedSolution& loaded) {
+    int rows = State::ROWS;
+    int cols = State::COLS;
+    // Note: main only dispatches solution files of this board here
+    assert(options.rows == rows && options.cols == cols);
+
+    // a saved solution decides what is being played, or what the solve continues from
+    if (loaded.is_open()) {
+        const SolutionHeader& header = loaded.header();
+        options.winning_objective = header.winning_objective;
+        options.precision = loaded.precision();
+        options.reachable_only = header.reachable_only;
+        options.symmetry = header.symmetry;
+        options.first_objective = header.first_objective;
+        // Note: sparse and bitset indexes of reachable boards give the same tables
+        options.sparse = options.sparse && options.reachable_only && !options.symmetry;
+        if (!options.load_path.empty()) {
+            options.solve_to_completion = header.horizon == SolutionHeader::COMPLETE;
+            options.T = options.solve_to_completion ? 0 : header.horizon;
+        } else {
+            // resume a checkpoint, or extend a solution to a longer horizon
+            if (header.horizon == SolutionHeader::COMPLETE) {
+                std::cerr << "A solve to completion has no time steps left to resume" << std::endl;
+                return 1;
+            }
+            if (header.first_objective > 0) {
+                std::cerr << "A solve of several objectives cannot be resumed" << std::endl;
+                return 1;
+            }
+            if (!options.T_given) {
+                options.T = default_time_horizon(options.winning_objective);
+            }
+            if (header.horizon > options.T) {
+                std::cerr << "Solution file already holds " << header.horizon
+                          << " time steps, more than the horizon " << options.T << std::endl;
+                return 1;
+            }
+            options.solver.resume_steps = header.horizon;
+        }
+    } else if (!options.T_given) {
+        options.T = default_time_horizon(options.winning_objective);
+    }
+    // a single objective unless the tables hold lower ones too
+    if (options.first_objective == options.winning_objective) {
+        options.first_objective = 0;
+    }
+    const int first_objective = options.first_objective > 0 ? options.first_objective : options.winning_objective;
+    if (options.target_objective > 0
+        && (options.target_objective < first_objective || options.target_objective > options.winning_objective)) {
+        std::cerr << "Objective " << (2 << (options.target_objective - 1)) << " is not in the tables, which hold "
+                  << (2 << (first_objective - 1)) << " to " << (2 << (options.winning_objective - 1)) << std::endl;
+        return 1;
+    }
+    if (options.first_objective > 0 && !options.solver.time_policy_path.empty()) {
+        std::cerr << "Time policies hold a single objective, tables of several objectives have none" << std::endl;
+        return 1;
+    }
+    options.solver.checkpoint.header = solution_header(options);
+
+    int8_t winning_objective = options.winning_objective; // power of winning objective
+    // Note: the default horizon is computed from the objective entered by the user
+    // (see default_time_horizon for the worst case reasoning)
+    int T = options.T;
+
+    std::cout << "solved-2048 by Vincent Meduski" << std::endl;
+    std::cout << "Rows= " << rows << std::endl;
+    std::cout << "Columns= " << cols << std::endl;
+    if (options.solve_to_completion) {
+        std::cout << "Time horizon= complete" << std::endl;
+    } else {
+        std::cout << "Time horizon= " << std::setw(2) << T << std::endl;
+    }
+    std::cout << "Objective= " << std::setw(2) << ( 2 << (winning_objective-1) )<< std::endl;
+    if (options.first_objective > 0 || options.target_objective > 0) {
+        std::cout << "Objectives= " << (2 << (first_objective - 1)) << " to " << (2 << (winning_objective - 1))
+                  << ", playing for " << (2 << ((options.target_objective > 0 ? options.target_objective : winning_objective) - 1))
+                  << std::endl;
+    }
+    std::cout << "Precision= " << to_string(options.precision) << " ("
+              << value_bytes(options.precision) << " bytes per value)" << std::endl;
+    if (options.search) {
+        std::cout << "Searching each move..." << std::endl;
+    } else if (!options.load_path.empty()) {
+        std::cout << "Loading optimal policy from " << options.load_path << "..." << std::endl;
+    } else {
+        std::cout << "Executing backwards induction for optimal policy..." << std::endl;
+    }
+
+    // Note: a search has no tables, its boards do not need to be indexed
+    if (options.search) {
+        return solve_and_play<double>(options, ReachableIndex(), SparseIndex(), SymmetricIndex(), 0, loaded);
+    }
+
+    int64_t total_combinations = 0;
+    try {
+        total_combinations = state_space_size(winning_objective);
+    } catch (const std::overflow_error& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    // with --reachable, tables only hold the boards reachable from the empty board
+    ReachableIndex reachable;
+    SparseIndex sparse;
+    int64_t table_size = total_combinations;
+    util::ThreadPool index_pool(options.solver.threads);
+    if (options.sparse) {
+        auto bfs_start = std::chrono::steady_clock::now();
+        sparse = SparseIndex::build(winning_objective, index_pool);
+        std::chrono::duration<double> bfs_time = std::chrono::steady_clock::now() - bfs_start;
+        table_size = sparse.size();
+        std::cout << "Reachable states= " << table_size << " of " << total_combinations
+                  << " (" << 100.0 * table_size / total_combinations << "%), sparse index "
+                  << sparse.memory_bytes() / (1024.0 * 1024.0) << " MiB, built in "
+                  << bfs_time.count() << "s" << std::endl;
+    } else if (options.reachable_only) {
+        auto bfs_start = std::chrono::steady_clock::now();
+        reachable = ReachableIndex::build(winning_objective, index_pool);
+        std::chrono::duration<double> bfs_time = std::chrono::steady_clock::now() - bfs_start;
+        table_size = reachable.size();
+        std::cout << "Reachable states= " << table_size << " of " << total_combinations
+                  << " (" << 100.0 * table_size / total_combinations << "%), index "
+                  << reachable.memory_bytes() / (1024.0 * 1024.0) << " MiB, built in "
+                  << bfs_time.count() << "s" << std::endl;
+    }
+    // with --symmetry, tables hold one board per symmetry orbit
+    SymmetricIndex symmetric;
+    if (options.symmetry) {
+        auto symmetry_start = std::chrono::steady_clock::now();
+        symmetric = SymmetricIndex::build(winning_objective, index_pool,
+                                          options.reachable_only ? &reachable : nullptr);
+        std::chrono::duration<double> symmetry_time = std::chrono::steady_clock::now() - symmetry_start;
+        std::cout << "Symmetry orbits= " << symmetric.size() << " of " << table_size
+                  << " (" << 100.0 * symmetric.size() / table_size << "%), index "
+                  << symmetric.memory_bytes() / (1024.0 * 1024.0) << " MiB, built in "
+                  << symmetry_time.count() << "s" << std::endl;
+        table_size = symmetric.size();
+    }
+
+    switch (options.precision) {
+    case ValuePrecision::Float:
+        return solve_and_play<float>(options, reachable, sparse, symmetric, table_size, loaded);
+    case ValuePrecision::Fixed16:
+        return solve_and_play<Fixed16>(options, reachable, sparse, symmetric, table_size, loaded);
+    case ValuePrecision::Quantized8:
+        return solve_and_play<Quantized8>(options, reachable, sparse, symmetric, table_size, loaded);
+    case ValuePrecision::Double:
+        break;
+    }
+    return solve_and_play<double>(options, reachable, sparse, symmetric, table_size, loaded);
+}
+
+}  // namespace BOARD_NAMESPACE
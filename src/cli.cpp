@@ -0,0 +1,357 @@
+#include "cli.hpp"
+
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+int parse_int(const std::string& name, const std::string& text) {
+    try {
+        std::size_t parsed = 0;
+        int value = std::stoi(text, &parsed);
+        if (parsed != text.size()) {
+            throw std::invalid_argument(text);
+        }
+        return value;
+    } catch (const std::exception&) {
+        throw std::invalid_argument("Invalid value for " + name + ": " + text);
+    }
+}
+
+int64_t parse_int64(const std::string& name, const std::string& text) {
+    try {
+        std::size_t parsed = 0;
+        long long value = std::stoll(text, &parsed);
+        if (parsed != text.size()) {
+            throw std::invalid_argument(text);
+        }
+        return value;
+    } catch (const std::exception&) {
+        throw std::invalid_argument("Invalid value for " + name + ": " + text);
+    }
+}
+
+// "RxC" board size, rows and cols are only written when text is valid
+void parse_board(const std::string& text, int& rows, int& cols) {
+    const std::size_t separator = text.find('x');
+    if (separator == std::string::npos) {
+        throw std::invalid_argument("Invalid value for --board: " + text + " (expected rows x cols, eg 3x3)");
+    }
+    const int board_rows = parse_int("--board", text.substr(0, separator));
+    const int board_cols = parse_int("--board", text.substr(separator + 1));
+    if (!is_supported_board(board_rows, board_cols)) {
+        throw std::invalid_argument("Unsupported board " + text + ", this build plays " + supported_boards());
+    }
+    rows = board_rows;
+    cols = board_cols;
+}
+
+double parse_double(const std::string& name, const std::string& text) {
+    try {
+        std::size_t parsed = 0;
+        double value = std::stod(text, &parsed);
+        if (parsed != text.size()) {
+            throw std::invalid_argument(text);
+        }
+        return value;
+    } catch (const std::exception&) {
+        throw std::invalid_argument("Invalid value for " + name + ": " + text);
+    }
+}
+
+}  // namespace
+
+CliOptions parse_cli(int argc, char* argv[]) {
+    CliOptions options;
+    int positional = 0;
+    bool tolerance_given = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg.rfind("--", 0) != 0) {
+            // positional arguments: [winning_objective] [time_horizon]
+            if (positional == 0) {
+                options.winning_objective = parse_int("winning_objective", arg);
+            } else if (positional == 1) {
+                options.T = parse_int("time_horizon", arg);
+                options.T_given = true;
+            } else {
+                throw std::invalid_argument("Unexpected argument: " + arg);
+            }
+            positional++;
+            continue;
+        }
+
+        // flags without a value
+        if (arg == "--precompute-transitions") {
+            options.solver.precompute_transitions = true;
+            continue;
+        }
+        if (arg == "--reachable") {
+            options.reachable_only = true;
+            continue;
+        }
+        if (arg == "--sparse") {
+            options.reachable_only = true;
+            options.sparse = true;
+            continue;
+        }
+        if (arg == "--symmetry") {
+            options.symmetry = true;
+            continue;
+        }
+        if (arg == "--solve-to-completion") {
+            options.solve_to_completion = true;
+            continue;
+        }
+        if (arg == "--prioritized-sweeping") {
+            options.solve_to_completion = true;
+            options.prioritized_sweeping = true;
+            continue;
+        }
+        if (arg == "--gauss-seidel") {
+            options.solver.gauss_seidel = true;
+            continue;
+        }
+        if (arg == "--serve") {
+            options.serve = true;
+            continue;
+        }
+        if (arg == "--precision-error") {
+            options.precision_error = true;
+            continue;
+        }
+
+        // every option below takes exactly one value
+        if (i + 1 >= argc) {
+            throw std::invalid_argument("Missing value for " + arg);
+        }
+        std::string value = argv[++i];
+
+        if (arg == "--board") {
+            parse_board(value, options.rows, options.cols);
+        } else if (arg == "--threads") {
+            options.solver.threads = parse_int(arg, value);
+            if (options.solver.threads < 0) {
+                throw std::invalid_argument("--threads must be >= 0");
+            }
+        } else if (arg == "--processes") {
+            options.solver.processes = parse_int(arg, value);
+            if (options.solver.processes < 1) {
+                throw std::invalid_argument("--processes must be >= 1");
+            }
+        } else if (arg == "--chunk-size") {
+            options.solver.chunk_size = parse_int(arg, value);
+            if (options.solver.chunk_size <= 0) {
+                throw std::invalid_argument("--chunk-size must be > 0");
+            }
+        } else if (arg == "--tolerance") {
+            options.solver.tolerance = parse_double(arg, value);
+            tolerance_given = true;
+        } else if (arg == "--precision") {
+            options.precision = parse_value_precision(value);
+        } else if (arg == "--huge-pages") {
+            options.huge_pages = util::parse_huge_pages(value);
+        } else if (arg == "--simd") {
+            options.solver.simd = parse_simd_level(value);
+            if (!simd_supported(options.solver.simd)) {
+                throw std::invalid_argument("--simd " + value + " is not supported by this CPU (best is "
+                                            + to_string(detect_simd_level()) + ")");
+            }
+        } else if (arg == "--save") {
+            options.save_path = value;
+        } else if (arg == "--load") {
+            options.load_path = value;
+        } else if (arg == "--simulate") {
+            options.simulate_games = parse_int64(arg, value);
+            if (options.simulate_games <= 0) {
+                throw std::invalid_argument("--simulate must be > 0");
+            }
+        } else if (arg == "--seed") {
+            options.seed = static_cast<uint64_t>(parse_int64(arg, value));
+        } else if (arg == "--socket") {
+            options.socket_path = value;
+        } else if (arg == "--resume") {
+            options.resume_path = value;
+        } else if (arg == "--time-policy") {
+            options.solver.time_policy_path = value;
+        } else if (arg == "--objectives-from") {
+            options.first_objective = static_cast<int>(parse_int64(arg, value));
+            if (options.first_objective < 1) {
+                throw std::invalid_argument("--objectives-from must be >= 1");
+            }
+        } else if (arg == "--target") {
+            options.target_objective = static_cast<int>(parse_int64(arg, value));
+            if (options.target_objective < 1) {
+                throw std::invalid_argument("--target must be >= 1");
+            }
+        } else if (arg == "--search") {
+            options.search = true;
+            options.search_options.seconds_per_move = parse_double(arg, value) / 1000;
+            if (options.search_options.seconds_per_move < 0) {
+                throw std::invalid_argument("--search must be >= 0");
+            }
+        } else if (arg == "--search-depth") {
+            options.search_options.max_depth = static_cast<int>(parse_int64(arg, value));
+            if (options.search_options.max_depth < 0) {
+                throw std::invalid_argument("--search-depth must be >= 0");
+            }
+        } else if (arg == "--search-cutoff") {
+            options.search_options.min_probability = parse_double(arg, value);
+            if (options.search_options.min_probability < 0 || options.search_options.min_probability >= 1) {
+                throw std::invalid_argument("--search-cutoff must be in [0, 1)");
+            }
+        } else if (arg == "--search-table") {
+            const int64_t mebibytes = parse_int64(arg, value);
+            if (mebibytes < 1) {
+                throw std::invalid_argument("--search-table must be >= 1");
+            }
+            options.search_options.table_bytes = static_cast<size_t>(mebibytes) << 20;
+        } else if (arg == "--metrics") {
+            options.solver.metrics_path = value;
+        } else if (arg == "--checkpoint") {
+            options.solver.checkpoint.path = value;
+        } else if (arg == "--checkpoint-interval") {
+            options.solver.checkpoint.interval_seconds = parse_double(arg, value);
+            if (options.solver.checkpoint.interval_seconds < 0) {
+                throw std::invalid_argument("--checkpoint-interval must be >= 0");
+            }
+        } else {
+            throw std::invalid_argument("Unknown option: " + arg);
+        }
+    }
+
+    if (options.sparse && options.symmetry) {
+        throw std::invalid_argument("--symmetry indexes every hash, it cannot be combined with --sparse");
+    }
+    if (!options.load_path.empty() && !options.resume_path.empty()) {
+        throw std::invalid_argument("--load and --resume are exclusive");
+    }
+    if (options.solver.processes > 1 && (options.solver.gauss_seidel || options.solve_to_completion)) {
+        throw std::invalid_argument("--processes shards the sweeps of a time horizon, it cannot be combined with "
+                                    + std::string(options.solver.gauss_seidel ? "--gauss-seidel" : "--solve-to-completion"));
+    }
+    if (!options.solver.time_policy_path.empty() && options.solve_to_completion) {
+        throw std::invalid_argument("--time-policy keeps the policy of every time step, a solve to completion has none");
+    }
+    if (!options.solver.time_policy_path.empty() && !options.resume_path.empty()) {
+        throw std::invalid_argument("--time-policy needs every time step, it cannot be combined with --resume");
+    }
+    if (!options.solver.metrics_path.empty() && options.solve_to_completion) {
+        throw std::invalid_argument("--metrics reports time steps, a solve to completion has none");
+    }
+    if (!options.resume_path.empty() && options.solve_to_completion) {
+        throw std::invalid_argument("--resume continues a time horizon, not a solve to completion");
+    }
+    if (options.prioritized_sweeping && options.precision != ValuePrecision::Double) {
+        throw std::invalid_argument("--prioritized-sweeping updates double values in place, it cannot be combined with --precision");
+    }
+    if (options.winning_objective < 1) {
+        throw std::invalid_argument("winning_objective must be >= 1");
+    }
+#ifdef PACKED_STATE
+    // Note: tiles of the hashes go up to the objective, two of them merge into objective + 1
+    if (options.winning_objective > MAX_PACKED_OBJECTIVE) {
+        throw std::invalid_argument("Packed boards hold tiles up to 2^15, winning_objective must be <= "
+                                    + std::to_string(MAX_PACKED_OBJECTIVE));
+    }
+#endif
+    if (options.search) {
+        const char* conflict = !options.load_path.empty() ? "--load"
+                             : !options.resume_path.empty() ? "--resume"
+                             : !options.save_path.empty() ? "--save"
+                             : options.serve || !options.socket_path.empty() ? "--serve"
+                             : options.solve_to_completion ? "--solve-to-completion"
+                             : options.reachable_only ? "--reachable"
+                             : options.sparse ? "--sparse"
+                             : options.symmetry ? "--symmetry"
+                             : options.first_objective > 0 ? "--objectives-from"
+                             : !options.solver.checkpoint.path.empty() ? "--checkpoint"
+                             : !options.solver.time_policy_path.empty() ? "--time-policy"
+                             : !options.solver.metrics_path.empty() ? "--metrics" : nullptr;
+        if (conflict != nullptr) {
+            throw std::invalid_argument(std::string("--search plays without tables, it cannot be combined with ")
+                                        + conflict);
+        }
+    }
+    if (options.first_objective > options.winning_objective) {
+        throw std::invalid_argument("--objectives-from must be <= winning_objective");
+    }
+    if (options.first_objective > 0 && options.first_objective < options.winning_objective) {
+        const char* conflict = options.solve_to_completion ? "--solve-to-completion"
+                             : options.solver.processes > 1 ? "--processes"
+                             : options.solver.gauss_seidel ? "--gauss-seidel"
+                             : options.precision != ValuePrecision::Double ? "--precision"
+                             : !options.resume_path.empty() ? "--resume"
+                             : !options.solver.checkpoint.path.empty() ? "--checkpoint"
+                             : !options.solver.time_policy_path.empty() ? "--time-policy"
+                             : !options.solver.metrics_path.empty() ? "--metrics" : nullptr;
+        if (conflict != nullptr) {
+            throw std::invalid_argument(std::string("--objectives-from solves double values on threads, "
+                                                    "it cannot be combined with ") + conflict);
+        }
+    }
+    // Note: the default horizon depends on the board, it is computed once the board is known
+    if (!options.T_given && !tolerance_given) {
+        // the default horizon is conservative: stop as soon as values are fixed
+        options.solver.tolerance = 0;
+    }
+    return options;
+}
+
+std::string cli_usage(const char* program_name) {
+    return std::string("Usage: ") + program_name + " [winning_objective] [time_horizon] [options]\n"
+        "  --board RxC       board size, one of " + supported_boards() + " (default "
+        + std::to_string(DEFAULT_BOARD_ROWS) + "x" + std::to_string(DEFAULT_BOARD_COLS) + ")\n"
+        "  --threads N       threads for the backwards induction, 0 for all cores (default 1)\n"
+        "  --processes N     worker processes sharing the tables, each sweeping one shard of the\n"
+        "                    hashes on --threads threads (default 1, no workers)\n"
+        "  --chunk-size N    hashes handed to a thread at a time (default 4096)\n"
+        "  --precompute-transitions\n"
+        "                    build all transitions once, then sweep without replaying moves\n"
+        "  --simd L          instruction set of the precomputed backups: auto, scalar, sse4, avx2\n"
+        "                    or avx512 (default auto, the fastest on the first states)\n"
+        "  --huge-pages M    pages of the tables: auto (explicit if reserved, else transparent),\n"
+        "                    explicit, transparent or off (default auto)\n"
+        "  --reachable       only solve boards reachable from the empty board\n"
+        "  --sparse          like --reachable, with a hash map instead of a bitset over every hash,\n"
+        "                    for state spaces too large to index densely\n"
+        "  --symmetry        solve one board per reflection/rotation orbit\n"
+        "  --solve-to-completion\n"
+        "                    no time horizon, evaluate every board once by decreasing tile sum\n"
+        "  --prioritized-sweeping\n"
+        "                    no time horizon, only back up boards whose successors changed by\n"
+        "                    more than --tolerance, from a queue ordered by the size of the change\n"
+        "  --tolerance X     stop once no value changes by more than X in a sweep, negative to\n"
+        "                    run every time step (default 0 without time_horizon, else -1)\n"
+        "  --gauss-seidel    update values in place, no new_value table (single thread)\n"
+        "  --objectives-from N\n"
+        "                    solve every objective from 2^N to the winning one in the same sweeps,\n"
+        "                    with one value and action per objective and board\n"
+        "  --target N        objective 2^N the game, simulations and queries play for, one of\n"
+        "                    --objectives-from (default winning_objective)\n"
+        "  --precision P     value table entries: double, float, fixed16 or quant8 (default double)\n"
+        "  --precision-error also solve with double values and report the worst-case error\n"
+        "  --save FILE       write the policy and value tables to FILE after the solve\n"
+        "  --load FILE       map the tables of a saved solve instead of solving\n"
+        "  --checkpoint FILE write the tables to FILE periodically and when interrupted\n"
+        "  --checkpoint-interval S\n"
+        "                    seconds between two checkpoints (default 600)\n"
+        "  --time-policy FILE\n"
+        "                    write the policy of every time step to FILE during the solve, or with\n"
+        "                    --load play with the policy of each turn read from FILE\n"
+        "  --search MS       play with an expectimax search of MS milliseconds per move instead\n"
+        "                    of solving, 0 to search to --search-depth or the time horizon\n"
+        "  --search-depth D  deepest search in player moves (default 0, up to the time horizon)\n"
+        "  --search-cutoff P estimate instead of search chance branches less likely than P\n"
+        "                    (default 0.0001, 0 for none)\n"
+        "  --search-table M  MiB of the search transposition table (default 64)\n"
+        "  --metrics FILE    write the counters, throughput and peak memory of each time step\n"
+        "                    to FILE, one JSON object per line\n"
+        "  --resume FILE     continue from a checkpoint or saved solve up to time_horizon\n"
+        "  --serve           answer binary board queries on stdin/stdout instead of playing\n"
+        "  --socket PATH     answer binary board queries on a Unix domain socket\n"
+        "  --simulate N      play N games with the policy on --threads threads and report the win rate\n"
+        "  --seed S          seed of the simulated games (default 2048)\n";
+}
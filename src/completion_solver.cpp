@@ -0,0 +1,207 @@
+#include "completion_solver.hpp"
+#include "state.hpp"
+#include "state_index.hpp"
+#include "thread_pool.hpp"
+#include "interrupt_handler.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+namespace BOARD_NAMESPACE {
+
+namespace {
+
+// Boards of one tile sum that have not won, sorted by hash, with their values
+template <typename Storage>
+struct Layer {
+    int64_t sum = -1;
+    std::vector<int64_t> hashes;
+    std::vector<Storage> values;
+
+    reward_type value_of(int64_t hash) const {
+        auto it = std::lower_bound(hashes.begin(), hashes.end(), hash);
+        return decode_value(values[it - hashes.begin()]);
+    }
+};
+
+/*
+ * Appends the hash of every board with tiles in [0, winning_objective-1]
+ * whose tiles add up to remaining, filling cells from cell onward
+ */
+void enumerate_boards_with_sum(int winning_objective, int cell, int64_t remaining,
+                               int64_t hash, int64_t place_value, std::vector<int64_t>& out) {
+    if (cell == State::SIZE) {
+        if (remaining == 0) out.push_back(hash);
+        return;
+    }
+    // largest sum the cells left can still hold
+    const int64_t largest_tile_value = int64_t(1) << (winning_objective - 1);
+    if (remaining > largest_tile_value * (State::SIZE - cell)) {
+        return;
+    }
+    for (int tile = 0; tile < winning_objective; tile++) {
+        const int64_t tile_value = tile == 0 ? 0 : (int64_t(1) << tile);
+        if (tile_value > remaining) break;
+        enumerate_boards_with_sum(winning_objective, cell + 1, remaining - tile_value,
+                                  hash + tile * place_value, place_value * (winning_objective + 1), out);
+    }
+}
+
+}  // namespace
+
+int completion_time_horizon(int winning_objective) {
+    // a board that has not won holds at most SIZE tiles of 2^(winning_objective-1),
+    // and every turn adds at least 2 to the sum
+    const int64_t largest_sum = State::SIZE * (int64_t(1) << (winning_objective - 1));
+    return static_cast<int>(largest_sum / 2 + 2);
+}
+
+template <typename Index, typename Storage>
+void optimal_policy_to_completion(Table<action_type>& policy, Table<Storage>& value, int winning_objective, const Index& index, const SolverOptions& options) {
+    int threads = options.threads;
+    #ifdef DEBUG
+    threads = 1;
+    #endif
+    util::ThreadPool pool(threads);
+    if (pool.size() > 1) {
+        std::cout << "Threads= " << pool.size() << std::endl;
+    }
+    const bool fill_value = static_cast<int64_t>(value.size()) == index.size();
+
+    // hash the value of a board is stored under in the layers (canonical board for symmetries)
+    auto representative = [&](int64_t hash) { return index.hash_at(index.position(hash)); };
+    auto has_entry = [&](int64_t hash) {
+        int64_t position = index.position(hash);
+        return position < index.size() && index.hash_at(position) == hash;
+    };
+
+    // the two layers above the one being solved, at sum + 2 and sum + 4
+    Layer<Storage> above_2;
+    Layer<Storage> above_4;
+    size_t largest_layer = 0;
+
+    /*
+     * Backup of gamestate at sum, same expression and order of operations as bellman_backup.
+     * None keeps the board forever, it is worth the final reward.
+     */
+    auto backup = [&](const State& gamestate, [[maybe_unused]] int64_t sum, action_type& argmax) {
+        reward_type max_bellman_expression = -1;
+        argmax = Action::None;
+        for (auto a : Actions::All) {
+            reward_type bellman_expression = 0;
+            if (a == Action::None) {
+                bellman_expression = final_reward(winning_objective, gamestate);
+            } else {
+                std::optional<State> next_state = gamestate.player_move(a);
+                if (!next_state.has_value()) {
+                    bellman_expression = -1;
+                } else {
+                    std::vector<Coord> nature = next_state.value().all_nature_moves();
+                    const reward_type probability = 1.0 / (nature.size() * 2);
+                    State nature_move(next_state.value());
+                    for (std::size_t k = 0; k < nature.size(); k++) {
+                        for (int8_t tile : {int8_t(1), int8_t(2)}) {
+                            nature_move(nature[k].i, nature[k].j) = tile;
+                            reward_type successor_value = 1;
+                            if (final_reward(winning_objective, nature_move) == 0) {
+                                const Layer<Storage>& layer = tile == 1 ? above_2 : above_4;
+                                assert(layer.sum == sum + 2 * tile);
+                                successor_value = layer.value_of(
+                                    representative(gamestate_to_hash(winning_objective, nature_move)));
+                            }
+                            bellman_expression += successor_value * probability;
+                        }
+                        nature_move(nature[k].i, nature[k].j) = 0;
+                    }
+                }
+            }
+            if (bellman_expression > max_bellman_expression) {
+                argmax = a;
+                max_bellman_expression = bellman_expression;
+            }
+        }
+        return max_bellman_expression;
+    };
+
+    const int64_t largest_sum = State::SIZE * (int64_t(1) << (winning_objective - 1));
+    bool stopped = false;
+    for (int64_t sum = largest_sum; sum >= 2; sum -= 2) {
+        if (util::global_stop_requested.load()) {
+            std::cout << "\n[User Interrupt] Layered solve stopped at tile sum " << sum + 2 << std::endl;
+            util::global_stop_requested.store(false);
+            stopped = true;
+            break;
+        }
+
+        // boards of this layer that have an entry in the index
+        Layer<Storage> layer;
+        layer.sum = sum;
+        enumerate_boards_with_sum(winning_objective, 0, sum, 0, 1, layer.hashes);
+        layer.hashes.erase(std::remove_if(layer.hashes.begin(), layer.hashes.end(),
+                                          [&](int64_t hash) { return !has_entry(hash); }),
+                           layer.hashes.end());
+        std::sort(layer.hashes.begin(), layer.hashes.end());
+        layer.values.resize(layer.hashes.size());
+        largest_layer = std::max(largest_layer, layer.hashes.size());
+
+        pool.parallel_for(0, static_cast<int64_t>(layer.hashes.size()), options.chunk_size,
+            [&](int64_t chunk_begin, int64_t chunk_end) {
+                State gamestate;
+                for (int64_t k = chunk_begin; k < chunk_end; k++) {
+                    const int64_t hash = layer.hashes[k];
+                    hash_to_gamestate(winning_objective, hash, gamestate);
+                    action_type argmax;
+                    // Note: the only rounding of a backup, see bellman_backup
+                    layer.values[k] = encode_value<Storage>(backup(gamestate, sum, argmax));
+                    const int64_t position = index.position(hash);
+                    policy[position] = argmax;
+                    if (fill_value) value[position] = layer.values[k];
+                }
+            });
+
+        // layer sum + 4 is no longer needed
+        above_4 = std::move(above_2);
+        above_2 = std::move(layer);
+    }
+
+    if (stopped) {
+        return;
+    }
+
+    // empty board: the game has not started, no player move
+    policy[0] = Action::None;
+    if (fill_value) value[0] = encode_value<Storage>(0);
+
+    // boards that have won: worth 1, and all their successors have won too
+    above_2 = Layer<Storage>();
+    above_4 = Layer<Storage>();
+    pool.parallel_for(1, index.size(), options.chunk_size,
+        [&](int64_t chunk_begin, int64_t chunk_end) {
+            State gamestate;
+            for (int64_t position = chunk_begin; position < chunk_end; position++) {
+                hash_to_gamestate(winning_objective, index.hash_at(position), gamestate);
+                if (final_reward(winning_objective, gamestate) == 0) continue;
+                action_type argmax;
+                reward_type winning_value = backup(gamestate, -1, argmax);
+                policy[position] = argmax;
+                if (fill_value) value[position] = encode_value<Storage>(winning_value);
+            }
+        });
+
+    std::cout << "Largest layer= " << largest_layer << " boards ("
+              << largest_layer * (sizeof(int64_t) + sizeof(Storage)) / (1024.0 * 1024.0)
+              << " MiB, 3 layers in memory at most)" << std::endl;
+}
+
+#define INSTANTIATE_OPTIMAL_POLICY_TO_COMPLETION(Storage) \
+    template void optimal_policy_to_completion(Table<action_type>&, Table<Storage>&, int, const DenseIndex&, const SolverOptions&); \
+    template void optimal_policy_to_completion(Table<action_type>&, Table<Storage>&, int, const ReachableIndex&, const SolverOptions&); \
+    template void optimal_policy_to_completion(Table<action_type>&, Table<Storage>&, int, const SparseIndex&, const SolverOptions&); \
+    template void optimal_policy_to_completion(Table<action_type>&, Table<Storage>&, int, const SymmetricIndex&, const SolverOptions&);
+INSTANTIATE_OPTIMAL_POLICY_TO_COMPLETION(double)
+INSTANTIATE_OPTIMAL_POLICY_TO_COMPLETION(float)
+INSTANTIATE_OPTIMAL_POLICY_TO_COMPLETION(Fixed16)
+INSTANTIATE_OPTIMAL_POLICY_TO_COMPLETION(Quantized8)
+#undef INSTANTIATE_OPTIMAL_POLICY_TO_COMPLETION
+
+}  // namespace BOARD_NAMESPACE
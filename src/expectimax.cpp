@@ -0,0 +1,322 @@
+#include "expectimax.hpp"
+#include "utils.hpp"
+#include "random.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace BOARD_NAMESPACE {
+
+namespace {
+
+// Nodes between two looks at the clock, per thread
+constexpr int64_t DEADLINE_CHECK_NODES = 4096;
+// Smallest probability of a Nature move: a 2 or a 4 on one of the empty tiles of an afterstate, at most SIZE - 1
+constexpr double MIN_NATURE_PROBABILITY = 1.0 / (2 * (State::SIZE - 1));
+
+uint64_t value_bits(reward_type value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+reward_type bits_value(uint64_t bits) {
+    reward_type value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Moves left after a player move, negative moves_left (no horizon) stays negative
+int next_moves_left(int moves_left) {
+    return moves_left > 0 ? moves_left - 1 : moves_left;
+}
+
+// Key of the depth a value was searched to, the same board searched deeper is another entry
+uint64_t depth_key(uint64_t depth) {
+    return util::splitmix64(depth);
+}
+
+// Key of the rounded probability of a board searched with cut-offs, see max_node
+uint64_t probability_key(int exponent) {
+    // Note: apart from the depths, which stay below 2^32
+    uint64_t state = (uint64_t(1) << 32) | static_cast<uint32_t>(exponent);
+    return util::splitmix64(state);
+}
+
+}  // namespace
+
+/*
+ * Lock-free entry of the transposition table: writers store the value, then key ^ value.
+ * A reader only trusts an entry whose two words agree with its key, so an entry
+ * torn by two threads writing it at once reads as a miss instead of a wrong value.
+ */
+struct ExpectimaxSearch::Entry {
+    std::atomic<uint64_t> check{0};
+    std::atomic<uint64_t> value{0};
+};
+
+// Work of one thread, added to the statistics once its tasks are done
+struct ExpectimaxSearch::Counters {
+    int64_t nodes = 0;
+    int64_t probes = 0;
+    int64_t hits = 0;
+    int64_t cutoffs = 0;
+};
+
+std::string to_string(const SearchStatistics& statistics) {
+    std::ostringstream out;
+    out << statistics.moves << " moves, " << statistics.nodes << " nodes, " << std::setprecision(4)
+        << statistics.nodes_per_second() << " nodes/s, average depth "
+        << (statistics.moves > 0 ? static_cast<double>(statistics.depth_sum) / statistics.moves : 0)
+        << ", table hit rate " << 100 * statistics.hit_rate() << "%, " << statistics.cutoffs
+        << " probability cut-offs";
+    return out.str();
+}
+
+reward_type evaluate_board(int winning_objective, const State& board) {
+    int64_t tile_sum = 0;
+    int empty = 0;
+    for (int i = 0; i < State::ROWS; i++) {
+        for (int j = 0; j < State::COLS; j++) {
+            const int8_t tile = board(i, j);
+            tile_sum += tile == 0 ? 0 : int64_t(1) << tile;
+            empty += tile == 0;
+        }
+    }
+    // Note: a rough estimate, the tiles must add up to 2^winning_objective before it can be reached,
+    // and free cells keep a board away from a dead end; at most 0.5, a won board is worth 1
+    const reward_type progress = std::min<reward_type>(1, static_cast<reward_type>(tile_sum) / (int64_t(1) << winning_objective));
+    return 0.25 * progress * (1 + static_cast<reward_type>(empty) / State::SIZE);
+}
+
+ExpectimaxSearch::ExpectimaxSearch(int winning_objective, const SearchOptions& options)
+    : winning_objective_(winning_objective), options_(options), pool_(options.threads) {
+    if (options.seconds_per_move < 0 || options.max_depth < 0 || options.min_probability < 0) {
+        throw std::invalid_argument("Search time, depth and cut-off probability must be >= 0");
+    }
+    uint64_t seed = 0x2048;
+    for (auto& cell_keys : tile_keys_) {
+        cell_keys[0] = 0;
+        for (size_t tile = 1; tile < cell_keys.size(); tile++) {
+            cell_keys[tile] = util::splitmix64(seed);
+        }
+    }
+    table_size_ = 1;
+    while (table_size_ * 2 * sizeof(Entry) <= options.table_bytes) {
+        table_size_ *= 2;
+    }
+    table_.reset(new Entry[table_size_]);
+}
+
+ExpectimaxSearch::~ExpectimaxSearch() = default;
+
+uint64_t ExpectimaxSearch::board_key(const State& board) const {
+    uint64_t key = 0;
+    for (int i = 0; i < State::ROWS; i++) {
+        for (int j = 0; j < State::COLS; j++) {
+            key ^= tile_keys_[i * State::COLS + j][board(i, j)];
+        }
+    }
+    return key;
+}
+
+// value of a board that is not searched further
+static reward_type leaf_value(int winning_objective, const State& board, int moves_left) {
+    if (final_reward(winning_objective, board) > 0) return 1;
+    if (moves_left == 0) return 0;
+    return evaluate_board(winning_objective, board);
+}
+
+bool ExpectimaxSearch::count_node(Counters& counters) {
+    counters.nodes++;
+    if (has_deadline_ && counters.nodes % DEADLINE_CHECK_NODES == 0 && std::chrono::steady_clock::now() > deadline_) {
+        stop_.store(true, std::memory_order_relaxed);
+    }
+    return stop_.load(std::memory_order_relaxed);
+}
+
+reward_type ExpectimaxSearch::max_node(const State& board, int depth, int moves_left, double probability, Counters& counters) {
+    if (count_node(counters)) {
+        // Note: the iteration is abandoned, this value is never used
+        return 0;
+    }
+    if (depth == 0 || moves_left == 0 || final_reward(winning_objective_, board) > 0) {
+        return leaf_value(winning_objective_, board, moves_left);
+    }
+
+    // searched to the horizon, the value does not depend on the depth
+    const bool to_horizon = moves_left > 0 && moves_left <= depth;
+    uint64_t key = board_key(board) ^ depth_key(to_horizon ? 2 * uint64_t(moves_left) + 1 : 2 * uint64_t(depth));
+    // Note: with a cut-off below the board, its value depends on the probability of the path to it.
+    // It is searched with that probability rounded up to a power of 2, part of the key, so that
+    // every entry holds the value of its key alone and threads do not change the result
+    const int levels = to_horizon ? moves_left : depth;
+    if (probability * std::pow(MIN_NATURE_PROBABILITY, levels) < options_.min_probability) {
+        int exponent = std::ilogb(probability);
+        if (std::ldexp(1.0, exponent) < probability) {
+            exponent++;
+        }
+        probability = std::ldexp(1.0, exponent);
+        key ^= probability_key(exponent);
+    }
+    Entry& entry = table_[key & (table_size_ - 1)];
+    counters.probes++;
+    const uint64_t stored = entry.value.load(std::memory_order_relaxed);
+    if ((entry.check.load(std::memory_order_relaxed) ^ stored) == key) {
+        counters.hits++;
+        return bits_value(stored);
+    }
+
+    // a board without moves has lost, like Action::None in the Bellman backups
+    reward_type best = 0;
+    for (int a = 0; a < 4; a++) {
+        std::optional<State> afterstate = board.player_move(Actions::All[a]);
+        if (afterstate.has_value()) {
+            best = std::max(best, chance_node(afterstate.value(), depth, moves_left, probability, counters));
+        }
+    }
+    if (!stop_.load(std::memory_order_relaxed)) {
+        entry.value.store(value_bits(best), std::memory_order_relaxed);
+        entry.check.store(key ^ value_bits(best), std::memory_order_relaxed);
+    }
+    return best;
+}
+
+reward_type ExpectimaxSearch::chance_node(const State& afterstate, int depth, int moves_left, double probability, Counters& counters) {
+    // every empty tile gets a 2 or a 4, all equally likely
+    // Note: same successors in the same order as the Bellman backups, sums round the same way
+    const std::vector<Coord> tiles = afterstate.all_nature_moves();
+    const reward_type nature_probability = 1.0 / (2 * tiles.size());
+    const double child_probability = probability * nature_probability;
+    reward_type expectation = 0;
+    for (const Coord& tile : tiles) {
+        for (int8_t power : {int8_t(1), int8_t(2)}) {
+            State child = afterstate;
+            child(tile.i, tile.j) = power;
+            reward_type value;
+            if (child_probability < options_.min_probability) {
+                // Note: counted as nodes, the clock is also checked on subtrees that are all cut off
+                counters.cutoffs++;
+                if (count_node(counters)) {
+                    return 0;
+                }
+                value = leaf_value(winning_objective_, child, next_moves_left(moves_left));
+            } else {
+                value = max_node(child, depth - 1, next_moves_left(moves_left), child_probability, counters);
+            }
+            expectation += value * nature_probability;
+        }
+    }
+    return expectation;
+}
+
+SearchResult ExpectimaxSearch::search(const State& board, int moves_left) {
+    const auto start = std::chrono::steady_clock::now();
+    SearchResult result;
+    if (final_reward(winning_objective_, board) > 0 || moves_left == 0) {
+        result.value = final_reward(winning_objective_, board);
+        return result;
+    }
+    int depth_limit = options_.max_depth > 0 ? options_.max_depth : INT_MAX;
+    if (moves_left > 0) {
+        depth_limit = std::min(depth_limit, moves_left);
+    }
+    if (depth_limit == INT_MAX && options_.seconds_per_move <= 0) {
+        throw std::invalid_argument("A search without horizon needs a time or depth limit");
+    }
+    const int child_moves_left = next_moves_left(moves_left);
+
+    // the root is split in one task per player move and Nature move, their values are
+    // added up in order once all are done, so threads do not change the result (see max_node)
+    struct RootTask {
+        int action;
+        State child;
+    };
+    std::vector<RootTask> tasks;
+    std::array<reward_type, 4> nature_probability = {};
+    for (int a = 0; a < 4; a++) {
+        std::optional<State> afterstate = board.player_move(Actions::All[a]);
+        if (!afterstate.has_value()) continue;
+        const std::vector<Coord> tiles = afterstate->all_nature_moves();
+        nature_probability[a] = 1.0 / (2 * tiles.size());
+        for (const Coord& tile : tiles) {
+            for (int8_t power : {int8_t(1), int8_t(2)}) {
+                State child = afterstate.value();
+                child(tile.i, tile.j) = power;
+                tasks.push_back({a, child});
+            }
+        }
+    }
+
+    Counters totals;
+    std::mutex totals_mutex;
+    std::vector<reward_type> values(tasks.size());
+    deadline_ = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                            std::chrono::duration<double>(options_.seconds_per_move));
+    stop_.store(false);
+    for (int depth = 1; depth <= depth_limit && !tasks.empty(); depth++) {
+        // Note: the first iteration always completes, there is a move to play whatever the budget
+        has_deadline_ = options_.seconds_per_move > 0 && depth > 1;
+        pool_.parallel_for(0, static_cast<int64_t>(tasks.size()), 1, [&](int64_t begin, int64_t end) {
+            Counters counters;
+            for (int64_t t = begin; t < end; t++) {
+                const double probability = nature_probability[tasks[t].action];
+                if (probability < options_.min_probability) {
+                    counters.cutoffs++;
+                    count_node(counters);
+                    values[t] = leaf_value(winning_objective_, tasks[t].child, child_moves_left);
+                } else {
+                    values[t] = max_node(tasks[t].child, depth - 1, child_moves_left, probability, counters);
+                }
+            }
+            std::lock_guard<std::mutex> lock(totals_mutex);
+            totals.nodes += counters.nodes;
+            totals.probes += counters.probes;
+            totals.hits += counters.hits;
+            totals.cutoffs += counters.cutoffs;
+        });
+        if (stop_.load()) {
+            break;
+        }
+
+        result.action_values.fill(-1);
+        for (size_t t = 0; t < tasks.size(); t++) {
+            reward_type& action_value = result.action_values[tasks[t].action];
+            action_value = (action_value < 0 ? 0 : action_value) + values[t] * nature_probability[tasks[t].action];
+        }
+        result.action = Action::None;
+        result.value = 0;
+        for (int a = 0; a < 4; a++) {
+            if (result.action_values[a] > result.value || (result.action == Action::None && result.action_values[a] >= 0)) {
+                result.action = Actions::All[a];
+                result.value = result.action_values[a];
+            }
+        }
+        result.depth = depth;
+        if (options_.seconds_per_move > 0 && std::chrono::steady_clock::now() > deadline_) {
+            break;
+        }
+    }
+    has_deadline_ = false;
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    result.nodes = totals.nodes;
+    result.seconds = elapsed.count();
+    statistics_.moves++;
+    statistics_.nodes += totals.nodes;
+    statistics_.probes += totals.probes;
+    statistics_.hits += totals.hits;
+    statistics_.cutoffs += totals.cutoffs;
+    statistics_.depth_sum += result.depth;
+    statistics_.seconds += result.seconds;
+    return result;
+}
+
+}  // namespace BOARD_NAMESPACE
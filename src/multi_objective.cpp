@@ -0,0 +1,195 @@
+#include "multi_objective.hpp"
+#include "state.hpp"
+#include "state_index.hpp"
+#include "thread_pool.hpp"
+#include "transition_matrix.hpp"
+#include "successor_kernel.hpp"
+#include "interrupt_handler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+
+namespace BOARD_NAMESPACE {
+
+namespace {
+
+/*
+ * Bellman backup of every lane of the board at position, like bellman_backup for each objective:
+ * successors_after(a, out) writes the table positions of the successors after player action a
+ * and returns their number. Sums run over successors in the same order as the single
+ * objective backups, each lane on its own, so values are bit-identical.
+ */
+template <typename Successors>
+void backup_lanes(int64_t position, int lanes, const Successors& successors_after,
+                  action_type* policy, const reward_type* value, reward_type* new_value) {
+    int64_t successors[SuccessorKernel::MAX_SUCCESSORS];
+    reward_type expression[ObjectiveLanes::MAX_LANES];
+    reward_type max_expression[ObjectiveLanes::MAX_LANES];
+    action_type argmax[ObjectiveLanes::MAX_LANES];
+    std::fill(max_expression, max_expression + lanes, -1);
+    std::fill(argmax, argmax + lanes, Action::None);
+
+    for (int a = 0; a < TransitionMatrix::PLAYER_ACTIONS; a++) {
+        const int length = successors_after(a, successors);
+        // ignore invalid moves with sentinel penalty value
+        std::fill(expression, expression + lanes, length > 0 ? 0 : -1);
+        if (length > 0) {
+            const reward_type probability = 1.0 / length;
+            for (int k = 0; k < length; k++) {
+                const reward_type* successor = value + successors[k] * lanes;
+                for (int lane = 0; lane < lanes; lane++) {
+                    expression[lane] += successor[lane] * probability;
+                }
+            }
+        }
+        for (int lane = 0; lane < lanes; lane++) {
+            if (expression[lane] > max_expression[lane]) {
+                argmax[lane] = Actions::All[a];
+                max_expression[lane] = expression[lane];
+            }
+        }
+    }
+
+    // None skips the turn, the previous value of the same board
+    const reward_type* previous = value + position * lanes;
+    for (int lane = 0; lane < lanes; lane++) {
+        if (previous[lane] > max_expression[lane]) {
+            argmax[lane] = Action::None;
+            max_expression[lane] = previous[lane];
+        }
+    }
+    std::copy(max_expression, max_expression + lanes, new_value + position * lanes);
+    std::copy(argmax, argmax + lanes, policy + position * lanes);
+}
+
+}  // namespace
+
+template <typename Index>
+int optimal_policies(Table<action_type>& policy, Table<reward_type>& value, Table<reward_type>& new_value, ObjectiveLanes lanes, int T, const Index& index, const SolverOptions& options) {
+    if (lanes.first < 1 || lanes.count() < 1 || lanes.count() > ObjectiveLanes::MAX_LANES) {
+        throw std::invalid_argument("Objectives " + std::to_string(lanes.first) + " to " + std::to_string(lanes.last)
+                                    + " are not between 1 and " + std::to_string(ObjectiveLanes::MAX_LANES));
+    }
+    if (options.processes > 1 || options.gauss_seidel || options.resume_steps > 0
+        || !options.checkpoint.path.empty() || !options.time_policy_path.empty() || !options.metrics_path.empty()) {
+        throw std::invalid_argument("Solves of several objectives only run on threads, from the final reward");
+    }
+    const int64_t table_size = index.size();
+    const int count = lanes.count();
+    const size_t entries = static_cast<size_t>(table_size) * count;
+    if (policy.size() != entries || value.size() != entries || new_value.size() != entries) {
+        throw std::invalid_argument("Tables of several objectives need " + std::to_string(count)
+                                    + " entries per board");
+    }
+
+    int threads = options.threads;
+    #ifdef DEBUG
+    threads = 1;
+    #endif
+    util::ThreadPool pool(threads);
+    if (pool.size() > 1) {
+        std::cout << "Threads= " << pool.size() << std::endl;
+    }
+    std::cout << "Objectives= " << (2 << (lanes.first - 1)) << " to " << (2 << (lanes.last - 1)) << ", "
+              << count << " values per board" << std::endl;
+
+    // final reward of every objective
+    pool.parallel_for(0, table_size, options.chunk_size, [&](int64_t chunk_begin, int64_t chunk_end) {
+        SuccessorKernel kernel(lanes.last);
+        for (int64_t position = chunk_begin; position < chunk_end; position++) {
+            const State& board = kernel.seek(index.hash_at(position));
+            for (int lane = 0; lane < count; lane++) {
+                value[position * count + lane] = final_reward(lanes.first + lane, board);
+            }
+        }
+    });
+
+    // Note: the successors do not depend on the objective, one matrix serves every lane
+    TransitionMatrix transitions;
+    if (options.precompute_transitions) {
+        auto build_start = std::chrono::steady_clock::now();
+        transitions = TransitionMatrix::build(lanes.last, index, pool);
+        std::chrono::duration<double> build_time = std::chrono::steady_clock::now() - build_start;
+        std::cout << "Transition matrix: " << transitions.total_successors() << " successors, "
+                  << transitions.memory_bytes() / (1024.0 * 1024.0) << " MiB, built in "
+                  << build_time.count() << "s" << std::endl;
+    }
+    const bool track_changes = options.tolerance >= 0;
+
+    int iterations = 0;
+    bool interrupted = false;
+    reward_type max_change = 0;
+    for (int time = T-1; time >= 0; time--) {
+        if (util::global_stop_requested.load()) {
+            std::cout << "\n[User Interrupt] MDP backwards induction stopped at time " << time+1 << std::endl;
+            util::global_stop_requested.store(false);
+            interrupted = true;
+            break;
+        }
+        std::cout << "Time: " << time << std::endl;
+
+        // position 0 is the empty board, it has no valid moves for the player
+        std::fill(policy.begin(), policy.begin() + count, Action::None);
+        std::fill(new_value.begin(), new_value.begin() + count, 0);
+        max_change = 0;
+        std::mutex max_change_mutex;
+        pool.parallel_for(1, table_size, options.chunk_size, [&](int64_t chunk_begin, int64_t chunk_end) {
+            SuccessorKernel kernel(lanes.last);
+            for (int64_t position = chunk_begin; position < chunk_end; position++) {
+                if (options.precompute_transitions) {
+                    const transition_index_type* successors = transitions.successors(position);
+                    backup_lanes(position, count, [&](int a, int64_t* out) {
+                        const int length = transitions.block_length(position, a);
+                        std::copy(successors, successors + length, out);
+                        successors += length;
+                        return length;
+                    }, policy.data(), value.data(), new_value.data());
+                } else {
+                    kernel.seek(index.hash_at(position));
+                    backup_lanes(position, count, [&](int a, int64_t* out) {
+                        const int length = kernel.successors(Actions::All[a], out);
+                        for (int k = 0; k < length; k++) {
+                            out[k] = index.position(out[k]);
+                        }
+                        return length;
+                    }, policy.data(), value.data(), new_value.data());
+                }
+            }
+            if (track_changes) {
+                reward_type chunk_max_change = 0;
+                for (size_t entry = chunk_begin * count; entry < static_cast<size_t>(chunk_end) * count; entry++) {
+                    chunk_max_change = std::max(chunk_max_change, std::abs(new_value[entry] - value[entry]));
+                }
+                std::lock_guard<std::mutex> lock(max_change_mutex);
+                max_change = std::max(max_change, chunk_max_change);
+            }
+        });
+        value.swap(new_value);
+        iterations++;
+
+        // Note: a lane that converged earlier no longer changes, the solve stops once every lane has
+        if (track_changes && max_change <= options.tolerance) {
+            std::cout << "Converged at time " << time << ", max change= " << max_change
+                      << " <= tolerance= " << options.tolerance << std::endl;
+            break;
+        }
+    }
+
+    std::cout << "Iterations= " << iterations << " of " << T;
+    if (track_changes) {
+        std::cout << ", last max change= " << max_change;
+    }
+    std::cout << std::endl;
+    return interrupted ? iterations : T;
+}
+
+template int optimal_policies(Table<action_type>&, Table<reward_type>&, Table<reward_type>&, ObjectiveLanes, int, const DenseIndex&, const SolverOptions&);
+template int optimal_policies(Table<action_type>&, Table<reward_type>&, Table<reward_type>&, ObjectiveLanes, int, const ReachableIndex&, const SolverOptions&);
+template int optimal_policies(Table<action_type>&, Table<reward_type>&, Table<reward_type>&, ObjectiveLanes, int, const SparseIndex&, const SolverOptions&);
+template int optimal_policies(Table<action_type>&, Table<reward_type>&, Table<reward_type>&, ObjectiveLanes, int, const SymmetricIndex&, const SolverOptions&);
+
+}  // namespace BOARD_NAMESPACE
@@ -0,0 +1,220 @@
+#include "prioritized_sweeping.hpp"
+#include "state.hpp"
+#include "state_index.hpp"
+#include "thread_pool.hpp"
+#include "successor_kernel.hpp"
+#include "interrupt_handler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <queue>
+#include <utility>
+
+namespace BOARD_NAMESPACE {
+
+namespace {
+
+// Backups between two looks at the interrupt flag
+constexpr int64_t INTERRUPT_CHECK_BACKUPS = 1 << 16;
+// Successors of a board over all its player moves
+constexpr int MAX_BOARD_SUCCESSORS = TransitionMatrix::PLAYER_ACTIONS * SuccessorKernel::MAX_SUCCESSORS;
+
+/*
+ * Distinct successors of position with the length of their shortest block, sorted by position.
+ * @returns their number
+ */
+int distinct_successors(const TransitionMatrix& transitions, int64_t position,
+                        std::pair<transition_index_type, uint8_t>* out) {
+    const transition_index_type* successors = transitions.successors(position);
+    int count = 0;
+    for (int a = 0; a < TransitionMatrix::PLAYER_ACTIONS; a++) {
+        const int length = transitions.block_length(position, a);
+        for (int k = 0; k < length; k++) {
+            out[count++] = {successors[k], static_cast<uint8_t>(length)};
+        }
+        successors += length;
+    }
+    // Note: the same board can follow several moves, and several tiles of a move on symmetric tables
+    std::sort(out, out + count);
+    return static_cast<int>(std::unique(out, out + count, [](const auto& x, const auto& y) {
+        return x.first == y.first;
+    }) - out);
+}
+
+/*
+ * Bellman backup of position in place, same sums in the same order as bellman_backup_sparse,
+ * None last so that it only wins strictly.
+ * @returns the change of value
+ */
+reward_type backup_in_place(int64_t position, const TransitionMatrix& transitions,
+                            action_type* policy, reward_type* value) {
+    const transition_index_type* successors = transitions.successors(position);
+    reward_type max_bellman_expression = -1;
+    action_type argmax = Action::None;
+    for (int a = 0; a < TransitionMatrix::PLAYER_ACTIONS; a++) {
+        const int length = transitions.block_length(position, a);
+        // ignore invalid moves with sentinel penalty value
+        reward_type bellman_expression = -1;
+        if (length > 0) {
+            bellman_expression = 0;
+            const reward_type probability = 1.0 / length;
+            for (int k = 0; k < length; k++) {
+                bellman_expression += value[successors[k]] * probability;
+            }
+        }
+        successors += length;
+        if (bellman_expression > max_bellman_expression) {
+            argmax = Actions::All[a];
+            max_bellman_expression = bellman_expression;
+        }
+    }
+    const reward_type previous_value = value[position];
+    if (previous_value > max_bellman_expression) {
+        argmax = Action::None;
+        max_bellman_expression = previous_value;
+    }
+    value[position] = max_bellman_expression;
+    policy[position] = argmax;
+    return std::abs(max_bellman_expression - previous_value);
+}
+
+}  // namespace
+
+PredecessorIndex PredecessorIndex::build(const TransitionMatrix& transitions) {
+    const int64_t table_size = transitions.size();
+    PredecessorIndex index;
+    index.offsets_.assign(table_size + 1, 0);
+    std::pair<transition_index_type, uint8_t> successors[MAX_BOARD_SUCCESSORS];
+
+    // 1 - count the predecessors of every board, offsets_[s + 1] counts those of s
+    for (int64_t position = 0; position < table_size; position++) {
+        const int count = distinct_successors(transitions, position, successors);
+        for (int k = 0; k < count; k++) {
+            index.offsets_[successors[k].first + 1]++;
+        }
+    }
+
+    // 2 - prefix sum into per-board offsets
+    for (int64_t position = 0; position < table_size; position++) {
+        index.offsets_[position + 1] += index.offsets_[position];
+    }
+    index.predecessors_.resize(index.offsets_[table_size]);
+    index.block_lengths_.resize(index.offsets_[table_size]);
+
+    // 3 - fill, predecessors are visited in increasing position so every list comes out sorted
+    std::vector<uint64_t> cursor(index.offsets_.begin(), index.offsets_.end() - 1);
+    for (int64_t position = 0; position < table_size; position++) {
+        const int count = distinct_successors(transitions, position, successors);
+        for (int k = 0; k < count; k++) {
+            const uint64_t entry = cursor[successors[k].first]++;
+            index.predecessors_[entry] = static_cast<transition_index_type>(position);
+            index.block_lengths_[entry] = successors[k].second;
+        }
+    }
+    return index;
+}
+
+size_t PredecessorIndex::memory_bytes() const {
+    return offsets_.size() * sizeof(uint64_t)
+         + predecessors_.size() * (sizeof(transition_index_type) + sizeof(uint8_t));
+}
+
+template <typename Index>
+PrioritizedSweepReport optimal_policy_prioritized(Table<action_type>& policy, Table<reward_type>& value, int winning_objective, const Index& index, const SolverOptions& options) {
+    int threads = options.threads;
+    #ifdef DEBUG
+    threads = 1;
+    #endif
+    util::ThreadPool pool(threads);
+    if (pool.size() > 1) {
+        std::cout << "Threads= " << pool.size() << std::endl;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    const int64_t table_size = index.size();
+
+    TransitionMatrix transitions = TransitionMatrix::build(winning_objective, index, pool);
+    const PredecessorIndex predecessors = PredecessorIndex::build(transitions);
+    std::chrono::duration<double> build_time = std::chrono::steady_clock::now() - start;
+    std::cout << "Transition matrix and predecessor index: " << transitions.total_successors() << " successors, "
+              << predecessors.total_predecessors() << " predecessors, "
+              << (transitions.memory_bytes() + predecessors.memory_bytes()) / (1024.0 * 1024.0)
+              << " MiB, built in " << build_time.count() << "s" << std::endl;
+
+    // final reward, and the first valid move: the backup of a board whose successors are all worth the same
+    pool.parallel_for(0, table_size, options.chunk_size, [&](int64_t chunk_begin, int64_t chunk_end) {
+        SuccessorKernel kernel(winning_objective);
+        for (int64_t position = chunk_begin; position < chunk_end; position++) {
+            value[position] = final_reward(winning_objective, kernel.seek(index.hash_at(position)));
+            policy[position] = Action::None;
+            for (int a = TransitionMatrix::PLAYER_ACTIONS - 1; a >= 0; a--) {
+                if (transitions.block_length(position, a) > 0) {
+                    policy[position] = Actions::All[a];
+                }
+            }
+        }
+    });
+
+    const reward_type threshold = std::max<reward_type>(options.tolerance, 0);
+    // priority each board is queued with, 0 when it is not queued
+    // Note: a board queued again with a higher priority leaves a stale entry in the heap, skipped when popped
+    std::vector<reward_type> queued(table_size, 0);
+    std::priority_queue<std::pair<reward_type, int64_t>> queue;
+    auto queue_predecessors = [&](int64_t position, reward_type change) {
+        const transition_index_type* boards = predecessors.predecessors(position);
+        const uint8_t* lengths = predecessors.block_lengths(position);
+        for (int k = 0; k < predecessors.count(position); k++) {
+            const reward_type priority = change / lengths[k];
+            if (priority > threshold && priority > queued[boards[k]]) {
+                queued[boards[k]] = priority;
+                queue.push({priority, boards[k]});
+            }
+        }
+    };
+
+    // winning boards went from 0 to their final reward
+    for (int64_t position = 0; position < table_size; position++) {
+        if (value[position] > 0) {
+            queue_predecessors(position, value[position]);
+        }
+    }
+
+    PrioritizedSweepReport report;
+    report.states = table_size;
+    report.predecessors = static_cast<int64_t>(predecessors.total_predecessors());
+    report.converged = true;
+    while (!queue.empty()) {
+        if (report.backups % INTERRUPT_CHECK_BACKUPS == 0 && util::global_stop_requested.load()) {
+            std::cout << "\n[User Interrupt] Prioritized sweeping stopped with " << queue.size()
+                      << " boards queued" << std::endl;
+            util::global_stop_requested.store(false);
+            report.converged = false;
+            break;
+        }
+        const auto [priority, position] = queue.top();
+        queue.pop();
+        if (priority != queued[position]) {
+            continue;
+        }
+        queued[position] = 0;
+        const reward_type change = backup_in_place(position, transitions, policy.data(), value.data());
+        report.backups++;
+        if (change > 0) {
+            queue_predecessors(position, change);
+        }
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    report.seconds = elapsed.count();
+    std::cout << "Backups= " << report.backups << " of " << table_size << " states, "
+              << report.full_sweeps() << " full sweeps" << std::endl;
+    return report;
+}
+
+template PrioritizedSweepReport optimal_policy_prioritized(Table<action_type>&, Table<reward_type>&, int, const DenseIndex&, const SolverOptions&);
+template PrioritizedSweepReport optimal_policy_prioritized(Table<action_type>&, Table<reward_type>&, int, const ReachableIndex&, const SolverOptions&);
+template PrioritizedSweepReport optimal_policy_prioritized(Table<action_type>&, Table<reward_type>&, int, const SparseIndex&, const SolverOptions&);
+template PrioritizedSweepReport optimal_policy_prioritized(Table<action_type>&, Table<reward_type>&, int, const SymmetricIndex&, const SolverOptions&);
+
+}  // namespace BOARD_NAMESPACE
@@ -0,0 +1,312 @@
+#include "process_group.hpp"
+
+#include "table_allocator.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sched.h>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+namespace util {
+
+namespace {
+
+// Time between two looks at the done counters, by the workers and the coordinator
+// Note: far below the duration of a solver time step, and the waiting processes stay idle
+constexpr auto POLL_INTERVAL = std::chrono::microseconds(200);
+
+// "0-3,8,10-11" as written in /sys/devices/system/node/node*/cpulist
+std::vector<int> parse_cpu_list(const std::string& text) {
+    std::vector<int> cpus;
+    std::istringstream ranges(text);
+    std::string range;
+    while (std::getline(ranges, range, ',')) {
+        const size_t dash = range.find('-');
+        try {
+            const int first = std::stoi(range.substr(0, dash));
+            const int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last; cpu++) {
+                cpus.push_back(cpu);
+            }
+        } catch (const std::logic_error&) {
+            // blank line of a node without CPUs
+        }
+    }
+    return cpus;
+}
+
+std::string describe_exit(int status) {
+    if (WIFSIGNALED(status)) {
+        return std::string("killed by signal ") + std::to_string(WTERMSIG(status)) + " (" + strsignal(WTERMSIG(status)) + ")";
+    }
+    return "exited with status " + std::to_string(WEXITSTATUS(status));
+}
+
+}  // namespace
+
+SharedMemory::SharedMemory(size_t bytes) : size_(bytes) {
+    // Note: a zero length mapping is invalid, keep one page
+    data_ = mmap(nullptr, std::max<size_t>(bytes, 1), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (data_ == MAP_FAILED) {
+        data_ = nullptr;
+        throw std::runtime_error("Cannot map " + std::to_string(bytes) + " bytes of shared memory: " + std::strerror(errno));
+    }
+    // Note: shared pages are only huge when /sys/kernel/mm/transparent_hugepage/shmem_enabled allows it
+    if (bytes >= HUGE_PAGE_BYTES) {
+        madvise(data_, bytes, MADV_HUGEPAGE);
+    }
+}
+
+SharedMemory::~SharedMemory() {
+    if (data_ != nullptr) {
+        munmap(data_, std::max<size_t>(size_, 1));
+    }
+}
+
+SharedMemory::SharedMemory(SharedMemory&& other) noexcept : data_(other.data_), size_(other.size_) {
+    other.data_ = nullptr;
+    other.size_ = 0;
+}
+
+SharedMemory& SharedMemory::operator=(SharedMemory&& other) noexcept {
+    if (this != &other) {
+        if (data_ != nullptr) {
+            munmap(data_, std::max<size_t>(size_, 1));
+        }
+        data_ = other.data_;
+        size_ = other.size_;
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+    return *this;
+}
+
+std::vector<WorkerPlacement> plan_worker_placement(int processes) {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return std::vector<WorkerPlacement>(processes);
+    }
+
+    // the allowed CPUs of each node, nodes without any are left out
+    std::vector<WorkerPlacement> groups;
+    for (int node = 0;; node++) {
+        std::ifstream cpulist("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        std::string line;
+        if (!std::getline(cpulist, line)) {
+            break;
+        }
+        WorkerPlacement group{node, {}};
+        for (int cpu : parse_cpu_list(line)) {
+            if (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed)) {
+                group.cpus.push_back(cpu);
+            }
+        }
+        if (!group.cpus.empty()) {
+            groups.push_back(group);
+        }
+    }
+    if (groups.empty()) {
+        WorkerPlacement all;
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &allowed)) {
+                all.cpus.push_back(cpu);
+            }
+        }
+        groups.push_back(all);
+    }
+
+    std::vector<WorkerPlacement> placement(processes);
+    const int group_count = static_cast<int>(groups.size());
+    for (int w = 0; w < processes; w++) {
+        const WorkerPlacement& group = groups[w % group_count];
+        // the k-th of the workers of this group, and their number
+        const int64_t k = w / group_count;
+        const int64_t sharing = (processes - 1 - w % group_count) / group_count + 1;
+        const int64_t cpus = static_cast<int64_t>(group.cpus.size());
+        placement[w].node = group.node;
+        if (cpus < sharing) {
+            placement[w].cpus = {group.cpus[k % cpus]};
+        } else {
+            placement[w].cpus.assign(group.cpus.begin() + k * cpus / sharing, group.cpus.begin() + (k + 1) * cpus / sharing);
+        }
+    }
+    return placement;
+}
+
+std::string to_string(const WorkerPlacement& placement) {
+    std::ostringstream out;
+    for (size_t k = 0; k < placement.cpus.size(); k++) {
+        size_t last = k;
+        while (last + 1 < placement.cpus.size() && placement.cpus[last + 1] == placement.cpus[last] + 1) {
+            last++;
+        }
+        out << (k > 0 ? "," : "CPUs ") << placement.cpus[k];
+        if (last > k) {
+            out << "-" << placement.cpus[last];
+        }
+        k = last;
+    }
+    if (placement.cpus.empty()) {
+        out << "any CPU";
+    }
+    if (placement.node >= 0) {
+        out << " (node " << placement.node << ")";
+    }
+    return out.str();
+}
+
+// Written by the coordinator before bumping sequence, read by the workers after seeing it
+struct ProcessGroup::Control {
+    std::atomic<int64_t> sequence;
+    int64_t argument;
+    bool exit;
+};
+
+ProcessGroup::ProcessGroup(int processes, Task task) : task_(std::move(task)) {
+    static_assert(std::atomic<int64_t>::is_always_lock_free, "atomics in shared memory must not use a lock");
+    shared_ = SharedMemory(sizeof(Slot) * processes + sizeof(Control));
+    slots_ = static_cast<Slot*>(shared_.data());
+    control_ = reinterpret_cast<Control*>(slots_ + processes);
+    for (int w = 0; w < processes; w++) {
+        new (&slots_[w]) Slot{{0}, {0}, 0};
+    }
+    new (control_) Control{{0}, 0, false};
+    placement_ = plan_worker_placement(processes);
+
+    // buffered output would otherwise be written again by every worker
+    std::cout.flush();
+    std::cerr.flush();
+    const pid_t coordinator = getpid();
+    for (int w = 0; w < processes; w++) {
+        const pid_t pid = fork();
+        if (pid == 0) {
+            // die with the coordinator, also if it died before this line
+            prctl(PR_SET_PDEATHSIG, SIGKILL);
+            if (getppid() != coordinator) _exit(1);
+            // Note: the threads the worker starts inherit its CPUs
+            if (!placement_[w].cpus.empty()) {
+                cpu_set_t cpus;
+                CPU_ZERO(&cpus);
+                for (int cpu : placement_[w].cpus) {
+                    CPU_SET(cpu, &cpus);
+                }
+                sched_setaffinity(0, sizeof(cpus), &cpus);
+            }
+            worker_main(w);
+        }
+        if (pid < 0) {
+            const int error = errno;
+            stop_all(SIGKILL);
+            throw std::runtime_error(std::string("Cannot fork a worker process: ") + std::strerror(error));
+        }
+        workers_.push_back(pid);
+    }
+}
+
+ProcessGroup::~ProcessGroup() {
+    if (workers_.empty()) {
+        return;
+    }
+    control_->exit = true;
+    control_->sequence.store(++sequence_, std::memory_order_release);
+    for (pid_t pid : workers_) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+    }
+}
+
+void ProcessGroup::worker_main(int worker) {
+    std::signal(SIGINT, SIG_IGN);
+    int64_t seen = 0;
+    while (true) {
+        int64_t sequence;
+        while ((sequence = control_->sequence.load(std::memory_order_acquire)) == seen) {
+            std::this_thread::sleep_for(POLL_INTERVAL);
+        }
+        seen = sequence;
+        if (control_->exit) {
+            _exit(0);
+        }
+        Slot& slot = slots_[worker];
+        slot.progress.store(0, std::memory_order_relaxed);
+        try {
+            slot.result = task_(worker, control_->argument, slot.progress);
+        } catch (const std::exception& e) {
+            std::cerr << "Worker " << worker << " failed: " << e.what() << std::endl;
+            _exit(2);
+        }
+        slot.done.store(seen, std::memory_order_release);
+    }
+}
+
+std::vector<double> ProcessGroup::run(int64_t argument, const std::function<void(int64_t progress)>& on_wait,
+                                      double poll_seconds) {
+    if (workers_.empty()) {
+        throw WorkerFailure("No worker processes left");
+    }
+    control_->argument = argument;
+    control_->sequence.store(++sequence_, std::memory_order_release);
+
+    auto last_report = std::chrono::steady_clock::now();
+    while (true) {
+        bool all_done = true;
+        for (int w = 0; w < size(); w++) {
+            all_done = all_done && slots_[w].done.load(std::memory_order_acquire) == sequence_;
+        }
+        if (all_done) {
+            break;
+        }
+        // Note: a worker that finished its step keeps running, any exit is a failure
+        for (int w = 0; w < size(); w++) {
+            int status = 0;
+            if (waitpid(workers_[w], &status, WNOHANG) == workers_[w]) {
+                const std::string message = "Worker " + std::to_string(w) + " (pid " + std::to_string(workers_[w])
+                                          + ") " + describe_exit(status);
+                workers_.erase(workers_.begin() + w);
+                stop_all(SIGKILL);
+                throw WorkerFailure(message);
+            }
+        }
+        std::this_thread::sleep_for(POLL_INTERVAL);
+        std::chrono::duration<double> since_report = std::chrono::steady_clock::now() - last_report;
+        if (on_wait && since_report.count() >= poll_seconds) {
+            int64_t progress = 0;
+            for (int w = 0; w < size(); w++) {
+                progress += slots_[w].progress.load(std::memory_order_relaxed);
+            }
+            on_wait(progress);
+            last_report = std::chrono::steady_clock::now();
+        }
+    }
+
+    std::vector<double> results(size());
+    for (int w = 0; w < size(); w++) {
+        results[w] = slots_[w].result;
+    }
+    return results;
+}
+
+void ProcessGroup::stop_all(int signal) {
+    for (pid_t pid : workers_) {
+        kill(pid, signal);
+    }
+    for (pid_t pid : workers_) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+    }
+    workers_.clear();
+}
+
+}
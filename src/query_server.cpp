@@ -0,0 +1,152 @@
+#include "query_server.hpp"
+#include "interrupt_handler.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace BOARD_NAMESPACE {
+
+namespace {
+
+// How often blocked reads and accepts check for Ctrl+C, in milliseconds
+constexpr int STOP_POLL_MS = 200;
+
+// Waits until fd is readable, false on Ctrl+C or error
+bool wait_readable(int fd) {
+    while (!util::global_stop_requested.load()) {
+        pollfd waiting = {fd, POLLIN, 0};
+        int ready = ::poll(&waiting, 1, STOP_POLL_MS);
+        if (ready > 0) return true;
+        if (ready < 0 && errno != EINTR) return false;
+    }
+    return false;
+}
+
+// Reads exactly length bytes, false on end of stream, error or Ctrl+C
+bool read_fully(int fd, void* buffer, size_t length) {
+    char* out = static_cast<char*>(buffer);
+    while (length > 0) {
+        if (!wait_readable(fd)) return false;
+        ssize_t got = ::read(fd, out, length);
+        if (got == 0) return false;
+        if (got < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            return false;
+        }
+        out += got;
+        length -= static_cast<size_t>(got);
+    }
+    return true;
+}
+
+bool write_fully(int fd, const void* buffer, size_t length) {
+    const char* in = static_cast<const char*>(buffer);
+    while (length > 0) {
+        ssize_t sent = ::write(fd, in, length);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        in += sent;
+        length -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+}  // namespace
+
+QueryStatistics serve_queries(int in_fd, int out_fd, const QueryLookup& lookup) {
+    // a closed client must end the session, not the process
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::vector<uint64_t> boards(MAX_QUERY_BATCH);
+    std::vector<QueryAnswer> answers(MAX_QUERY_BATCH);
+    QueryStatistics statistics;
+    auto start = std::chrono::steady_clock::now();
+
+    uint32_t count = 0;
+    while (read_fully(in_fd, &count, sizeof(count)) && count > 0 && count <= MAX_QUERY_BATCH) {
+        if (!read_fully(in_fd, boards.data(), count * sizeof(uint64_t))) break;
+        lookup(boards.data(), answers.data(), count);
+        if (!write_fully(out_fd, answers.data(), count * sizeof(QueryAnswer))) break;
+        statistics.batches++;
+        statistics.queries += count;
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    statistics.seconds = elapsed.count();
+    return statistics;
+}
+
+QueryStatistics serve_unix_socket(const std::string& path, const QueryLookup& lookup) {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Socket path too long: " + path);
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        throw std::runtime_error(std::string("Cannot create socket: ") + std::strerror(errno));
+    }
+    // Note: a socket file left by a previous server would make bind fail
+    ::unlink(path.c_str());
+    if (::bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0
+        || ::listen(listener, SOMAXCONN) != 0) {
+        std::string reason = std::strerror(errno);
+        ::close(listener);
+        throw std::runtime_error("Cannot listen on " + path + ": " + reason);
+    }
+
+    QueryStatistics total;
+    std::mutex total_mutex;
+    std::condition_variable session_ended;
+    int open_sessions = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    while (wait_readable(listener)) {
+        int client = ::accept(listener, nullptr, nullptr);
+        if (client < 0) continue;
+        {
+            std::lock_guard<std::mutex> lock(total_mutex);
+            open_sessions++;
+        }
+        // Note: detached so that finished sessions release their thread right away
+        std::thread([&, client]() {
+            QueryStatistics session = serve_queries(client, client, lookup);
+            ::close(client);
+            std::lock_guard<std::mutex> lock(total_mutex);
+            total.batches += session.batches;
+            total.queries += session.queries;
+            open_sessions--;
+            session_ended.notify_all();
+        }).detach();
+    }
+
+    // sessions see the stop request within STOP_POLL_MS
+    {
+        std::unique_lock<std::mutex> lock(total_mutex);
+        session_ended.wait(lock, [&] { return open_sessions == 0; });
+    }
+    ::close(listener);
+    ::unlink(path.c_str());
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    total.seconds = elapsed.count();
+    return total;
+}
+
+}  // namespace BOARD_NAMESPACE
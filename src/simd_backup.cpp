@@ -0,0 +1,343 @@
+#include "simd_backup.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_BACKUP_X86
+#include <immintrin.h>
+#endif
+
+static_assert(sizeof(transition_index_type) == 4, "successor gathers load 32-bit positions");
+
+std::string to_string(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::Auto:   return "auto";
+    case SimdLevel::Scalar: return "scalar";
+    case SimdLevel::SSE4:   return "sse4";
+    case SimdLevel::AVX2:   return "avx2";
+    case SimdLevel::AVX512: return "avx512";
+    }
+    return "auto";
+}
+
+SimdLevel parse_simd_level(const std::string& name) {
+    for (SimdLevel level : {SimdLevel::Auto, SimdLevel::Scalar, SimdLevel::SSE4, SimdLevel::AVX2, SimdLevel::AVX512}) {
+        if (name == to_string(level)) {
+            return level;
+        }
+    }
+    throw std::invalid_argument("Unknown SIMD level: " + name + " (auto, scalar, sse4, avx2 or avx512)");
+}
+
+SimdLevel detect_simd_level() {
+#ifdef SIMD_BACKUP_X86
+    // Note: also checks that the operating system saves the wider registers
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return SimdLevel::AVX512;
+    if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("sse4.1")) return SimdLevel::SSE4;
+#endif
+    return SimdLevel::Scalar;
+}
+
+bool simd_supported(SimdLevel level) {
+    return level == SimdLevel::Auto || static_cast<int>(level) <= static_cast<int>(detect_simd_level());
+}
+
+SimdLevel resolve_simd_level(SimdLevel level) {
+    if (level == SimdLevel::Auto) {
+        return detect_simd_level();
+    }
+    if (!simd_supported(level)) {
+        throw std::invalid_argument("SIMD level " + to_string(level) + " is not supported by this CPU (best is "
+                                    + to_string(detect_simd_level()) + ")");
+    }
+    return level;
+}
+
+namespace {
+
+constexpr int PLAYER_ACTIONS = TransitionBlocks::PLAYER_ACTIONS;
+constexpr double NONE = static_cast<double>(Action::None);
+
+/*
+ * Same backup as bellman_backup_sparse, one state at a time:
+ * for the levels without SIMD and for the states after the last full batch
+ */
+void backup_scalar(const TransitionBlocks& transitions, int64_t begin, int64_t end,
+                   const double* value, double* new_value, action_type* policy) {
+    for (int64_t position = begin; position < end; position++) {
+        const transition_index_type* successors = transitions.successors + transitions.state_offsets[position];
+        double max_bellman_expression = -1;
+        action_type argmax = Action::None;
+        for (int a = 0; a < PLAYER_ACTIONS; a++) {
+            const int length = transitions.action_lengths[position * PLAYER_ACTIONS + a];
+            double bellman_expression = -1;
+            if (length > 0) {
+                bellman_expression = 0;
+                const double probability = 1.0 / length;
+                for (int k = 0; k < length; k++) {
+                    bellman_expression += value[successors[k]] * probability;
+                }
+            }
+            successors += length;
+            if (bellman_expression > max_bellman_expression) {
+                argmax = Actions::All[a];
+                max_bellman_expression = bellman_expression;
+            }
+        }
+        if (value[position] > max_bellman_expression) {
+            argmax = Action::None;
+            max_bellman_expression = value[position];
+        }
+        new_value[position] = max_bellman_expression;
+        policy[position] = argmax;
+    }
+}
+
+#ifdef SIMD_BACKUP_X86
+
+/*
+ * Structure of arrays view of LANES consecutive states: for each action,
+ * where the block of every lane starts, its length and its probability.
+ * The loops over k sum the four actions at once, so that their additions overlap
+ * instead of waiting on each other.
+ */
+template <int LANES>
+struct Batch {
+    alignas(64) int64_t cursors[PLAYER_ACTIONS][LANES];
+    alignas(64) int32_t lengths[PLAYER_ACTIONS][LANES];
+    // lengths as doubles, to compare with the successor being summed
+    alignas(64) double counts[PLAYER_ACTIONS][LANES];
+    alignas(64) double probabilities[PLAYER_ACTIONS][LANES];
+    // longest block of the batch
+    int max_length;
+
+    void load(const TransitionBlocks& transitions, int64_t position) {
+        max_length = 0;
+        for (int lane = 0; lane < LANES; lane++) {
+            int64_t cursor = static_cast<int64_t>(transitions.state_offsets[position + lane]);
+            for (int a = 0; a < PLAYER_ACTIONS; a++) {
+                const int length = transitions.action_lengths[(position + lane) * PLAYER_ACTIONS + a];
+                cursors[a][lane] = cursor;
+                lengths[a][lane] = length;
+                counts[a][lane] = length;
+                probabilities[a][lane] = length > 0 ? 1.0 / length : 0;
+                max_length = std::max(max_length, length);
+                cursor += length;
+            }
+        }
+    }
+
+    void store_policy(const double* actions, action_type* policy) const {
+        for (int lane = 0; lane < LANES; lane++) {
+            policy[lane] = static_cast<action_type>(static_cast<int>(actions[lane]));
+        }
+    }
+};
+
+__attribute__((target("sse4.1")))
+void backup_sse4(const TransitionBlocks& transitions, int64_t begin, int64_t end,
+                 const double* value, double* new_value, action_type* policy) {
+    constexpr int LANES = 2;
+    Batch<LANES> batch;
+    int64_t position = begin;
+    for (; position + LANES <= end; position += LANES) {
+        batch.load(transitions, position);
+        __m128d count[PLAYER_ACTIONS];
+        __m128d probability[PLAYER_ACTIONS];
+        __m128d sum[PLAYER_ACTIONS];
+        for (int a = 0; a < PLAYER_ACTIONS; a++) {
+            count[a] = _mm_load_pd(batch.counts[a]);
+            probability[a] = _mm_load_pd(batch.probabilities[a]);
+            sum[a] = _mm_setzero_pd();
+        }
+        for (int k = 0; k < batch.max_length; k++) {
+            const __m128d step = _mm_set1_pd(k);
+            for (int a = 0; a < PLAYER_ACTIONS; a++) {
+                // Note: no gather before AVX2, each load fills one half of the register,
+                // lanes past the end of their block load 0 and are blended out
+                static constexpr double ZERO = 0;
+                const double* successor_value_of[LANES];
+                for (int lane = 0; lane < LANES; lane++) {
+                    successor_value_of[lane] = k < batch.lengths[a][lane]
+                        ? value + transitions.successors[batch.cursors[a][lane] + k] : &ZERO;
+                }
+                const __m128d successor_value = _mm_loadh_pd(_mm_load_sd(successor_value_of[0]), successor_value_of[1]);
+                const __m128d active = _mm_cmpgt_pd(count[a], step);
+                sum[a] = _mm_blendv_pd(sum[a], _mm_add_pd(sum[a], _mm_mul_pd(successor_value, probability[a])), active);
+            }
+        }
+        __m128d best = _mm_set1_pd(-1);
+        __m128d argmax = _mm_set1_pd(NONE);
+        for (int a = 0; a < PLAYER_ACTIONS; a++) {
+            // invalid moves are worth the sentinel -1
+            const __m128d valid = _mm_cmpgt_pd(count[a], _mm_setzero_pd());
+            const __m128d expression = _mm_blendv_pd(_mm_set1_pd(-1), sum[a], valid);
+            const __m128d greater = _mm_cmpgt_pd(expression, best);
+            best = _mm_blendv_pd(best, expression, greater);
+            argmax = _mm_blendv_pd(argmax, _mm_set1_pd(a), greater);
+        }
+        // None skips the turn, it is evaluated last so that it only wins strictly
+        const __m128d previous = _mm_loadu_pd(value + position);
+        const __m128d greater = _mm_cmpgt_pd(previous, best);
+        best = _mm_blendv_pd(best, previous, greater);
+        argmax = _mm_blendv_pd(argmax, _mm_set1_pd(NONE), greater);
+
+        _mm_storeu_pd(new_value + position, best);
+        alignas(16) double actions[LANES];
+        _mm_store_pd(actions, argmax);
+        batch.store_policy(actions, policy + position);
+    }
+    backup_scalar(transitions, position, end, value, new_value, policy);
+}
+
+__attribute__((target("avx2")))
+void backup_avx2(const TransitionBlocks& transitions, int64_t begin, int64_t end,
+                 const double* value, double* new_value, action_type* policy) {
+    constexpr int LANES = 4;
+    const int* successor_array = reinterpret_cast<const int*>(transitions.successors);
+    Batch<LANES> batch;
+    int64_t position = begin;
+    for (; position + LANES <= end; position += LANES) {
+        batch.load(transitions, position);
+        __m256i cursor[PLAYER_ACTIONS];
+        __m128i length[PLAYER_ACTIONS];
+        __m256d count[PLAYER_ACTIONS];
+        __m256d probability[PLAYER_ACTIONS];
+        __m256d sum[PLAYER_ACTIONS];
+        for (int a = 0; a < PLAYER_ACTIONS; a++) {
+            cursor[a] = _mm256_load_si256(reinterpret_cast<const __m256i*>(batch.cursors[a]));
+            length[a] = _mm_load_si128(reinterpret_cast<const __m128i*>(batch.lengths[a]));
+            count[a] = _mm256_load_pd(batch.counts[a]);
+            probability[a] = _mm256_load_pd(batch.probabilities[a]);
+            sum[a] = _mm256_setzero_pd();
+        }
+        for (int k = 0; k < batch.max_length; k++) {
+            for (int a = 0; a < PLAYER_ACTIONS; a++) {
+                // lanes past the end of their block do not load anything
+                const __m128i active_32 = _mm_cmpgt_epi32(length[a], _mm_set1_epi32(k));
+                const __m256d active = _mm256_castsi256_pd(_mm256_cvtepi32_epi64(active_32));
+                const __m256i index = _mm256_add_epi64(cursor[a], _mm256_set1_epi64x(k));
+                const __m128i successors = _mm256_mask_i64gather_epi32(_mm_setzero_si128(), successor_array, index, active_32, 4);
+                const __m256d successor_value = _mm256_mask_i64gather_pd(
+                    _mm256_setzero_pd(), value, _mm256_cvtepu32_epi64(successors), active, 8);
+                sum[a] = _mm256_blendv_pd(sum[a], _mm256_add_pd(sum[a], _mm256_mul_pd(successor_value, probability[a])), active);
+            }
+        }
+        __m256d best = _mm256_set1_pd(-1);
+        __m256d argmax = _mm256_set1_pd(NONE);
+        for (int a = 0; a < PLAYER_ACTIONS; a++) {
+            // invalid moves are worth the sentinel -1
+            const __m256d valid = _mm256_cmp_pd(count[a], _mm256_setzero_pd(), _CMP_GT_OQ);
+            const __m256d expression = _mm256_blendv_pd(_mm256_set1_pd(-1), sum[a], valid);
+            const __m256d greater = _mm256_cmp_pd(expression, best, _CMP_GT_OQ);
+            best = _mm256_blendv_pd(best, expression, greater);
+            argmax = _mm256_blendv_pd(argmax, _mm256_set1_pd(a), greater);
+        }
+        // None skips the turn, it is evaluated last so that it only wins strictly
+        const __m256d previous = _mm256_loadu_pd(value + position);
+        const __m256d greater = _mm256_cmp_pd(previous, best, _CMP_GT_OQ);
+        best = _mm256_blendv_pd(best, previous, greater);
+        argmax = _mm256_blendv_pd(argmax, _mm256_set1_pd(NONE), greater);
+
+        _mm256_storeu_pd(new_value + position, best);
+        alignas(32) double actions[LANES];
+        _mm256_store_pd(actions, argmax);
+        batch.store_policy(actions, policy + position);
+    }
+    backup_scalar(transitions, position, end, value, new_value, policy);
+}
+
+__attribute__((target("avx512f")))
+void backup_avx512(const TransitionBlocks& transitions, int64_t begin, int64_t end,
+                   const double* value, double* new_value, action_type* policy) {
+    constexpr int LANES = 8;
+    Batch<LANES> batch;
+    int64_t position = begin;
+    for (; position + LANES <= end; position += LANES) {
+        batch.load(transitions, position);
+        __m512i cursor[PLAYER_ACTIONS];
+        __m512d count[PLAYER_ACTIONS];
+        __m512d probability[PLAYER_ACTIONS];
+        __m512d sum[PLAYER_ACTIONS];
+        for (int a = 0; a < PLAYER_ACTIONS; a++) {
+            cursor[a] = _mm512_load_si512(batch.cursors[a]);
+            count[a] = _mm512_load_pd(batch.counts[a]);
+            probability[a] = _mm512_load_pd(batch.probabilities[a]);
+            sum[a] = _mm512_setzero_pd();
+        }
+        for (int k = 0; k < batch.max_length; k++) {
+            const __m512d step = _mm512_set1_pd(k);
+            for (int a = 0; a < PLAYER_ACTIONS; a++) {
+                // Note: masked forms, the unmasked ones trip -Wmaybe-uninitialized in GCC 12 headers
+                const __mmask8 active = _mm512_cmp_pd_mask(count[a], step, _CMP_GT_OQ);
+                const __m512i index = _mm512_add_epi64(cursor[a], _mm512_set1_epi64(k));
+                const __m256i successors = _mm512_mask_i64gather_epi32(
+                    _mm256_setzero_si256(), active, index, transitions.successors, 4);
+                const __m512d successor_value = _mm512_mask_i64gather_pd(
+                    _mm512_setzero_pd(), active, _mm512_maskz_cvtepu32_epi64(active, successors), value, 8);
+                sum[a] = _mm512_mask_add_pd(sum[a], active, sum[a], _mm512_mul_pd(successor_value, probability[a]));
+            }
+        }
+        __m512d best = _mm512_set1_pd(-1);
+        __m512d argmax = _mm512_set1_pd(NONE);
+        for (int a = 0; a < PLAYER_ACTIONS; a++) {
+            // invalid moves are worth the sentinel -1
+            const __mmask8 valid = _mm512_cmp_pd_mask(count[a], _mm512_setzero_pd(), _CMP_GT_OQ);
+            const __m512d expression = _mm512_mask_blend_pd(valid, _mm512_set1_pd(-1), sum[a]);
+            const __mmask8 greater = _mm512_cmp_pd_mask(expression, best, _CMP_GT_OQ);
+            best = _mm512_mask_blend_pd(greater, best, expression);
+            argmax = _mm512_mask_blend_pd(greater, argmax, _mm512_set1_pd(a));
+        }
+        // None skips the turn, it is evaluated last so that it only wins strictly
+        const __m512d previous = _mm512_loadu_pd(value + position);
+        const __mmask8 greater = _mm512_cmp_pd_mask(previous, best, _CMP_GT_OQ);
+        best = _mm512_mask_blend_pd(greater, best, previous);
+        argmax = _mm512_mask_blend_pd(greater, argmax, _mm512_set1_pd(NONE));
+
+        _mm512_storeu_pd(new_value + position, best);
+        alignas(64) double actions[LANES];
+        _mm512_store_pd(actions, argmax);
+        batch.store_policy(actions, policy + position);
+    }
+    backup_scalar(transitions, position, end, value, new_value, policy);
+}
+
+#endif
+
+}  // namespace
+
+void simd_bellman_backup(SimdLevel level, const TransitionBlocks& transitions, int64_t begin, int64_t end,
+                         const double* value, double* new_value, action_type* policy) {
+    switch (level) {
+#ifdef SIMD_BACKUP_X86
+    case SimdLevel::SSE4:   return backup_sse4(transitions, begin, end, value, new_value, policy);
+    case SimdLevel::AVX2:   return backup_avx2(transitions, begin, end, value, new_value, policy);
+    case SimdLevel::AVX512: return backup_avx512(transitions, begin, end, value, new_value, policy);
+#endif
+    default:                return backup_scalar(transitions, begin, end, value, new_value, policy);
+    }
+}
+
+SimdLevel fastest_simd_level(const TransitionBlocks& transitions, int64_t begin, int64_t end,
+                             const double* value, double* new_value, action_type* policy) {
+    SimdLevel fastest = SimdLevel::Scalar;
+    double fastest_seconds = 0;
+    for (SimdLevel level : {SimdLevel::Scalar, SimdLevel::SSE4, SimdLevel::AVX2, SimdLevel::AVX512}) {
+        if (!simd_supported(level)) continue;
+        // Note: best of 3, the first run also warms the caches for the others
+        for (int run = 0; run < 3; run++) {
+            auto start = std::chrono::steady_clock::now();
+            simd_bellman_backup(level, transitions, begin, end, value, new_value, policy);
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            if (fastest_seconds == 0 || elapsed.count() < fastest_seconds) {
+                fastest = level;
+                fastest_seconds = elapsed.count();
+            }
+        }
+    }
+    return fastest;
+}
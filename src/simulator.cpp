@@ -0,0 +1,70 @@
+#include "simulator.hpp"
+#include "utils.hpp"
+#include "random.hpp"
+#include "thread_pool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+
+namespace BOARD_NAMESPACE {
+
+void SimulationResult::confidence_interval(double& low, double& high) const {
+    if (games == 0) {
+        low = 0;
+        high = 1;
+        return;
+    }
+    // Note: unlike the normal approximation, stays in [0, 1] and is sensible for rates near 0 or 1
+    constexpr double z = 1.959963984540054;
+    const double n = static_cast<double>(games);
+    const double p = win_rate();
+    const double center = (p + z * z / (2 * n)) / (1 + z * z / n);
+    const double half_width = z / (1 + z * z / n) * std::sqrt(p * (1 - p) / n + z * z / (4 * n * n));
+    // Note: the bounds are exact when every game is lost or won
+    low = wins == 0 ? 0 : std::max(0.0, center - half_width);
+    high = wins == games ? 1 : std::min(1.0, center + half_width);
+}
+
+SimulationResult simulate_games(int winning_objective, const PolicyFunction& policy,
+                                const SimulationOptions& options) {
+    util::ThreadPool pool(options.threads);
+    std::atomic<int64_t> wins{0};
+    std::atomic<int64_t> player_moves{0};
+
+    auto start = std::chrono::steady_clock::now();
+    pool.parallel_for(0, options.games, options.chunk_size,
+        [&](int64_t chunk_begin, int64_t chunk_end) {
+            uint64_t stream = options.seed ^ (static_cast<uint64_t>(chunk_begin) * 0x9E3779B97F4A7C15ULL);
+            util::Xoshiro256 generator(util::splitmix64(stream));
+            int64_t chunk_wins = 0;
+            int64_t chunk_moves = 0;
+            for (int64_t game = chunk_begin; game < chunk_end; game++) {
+                // the first Nature move is always possible on the empty board
+                State gamestate = State().random_nature_move(generator).value();
+                for (int turn = 0; options.max_turns < 0 || turn < options.max_turns; turn++) {
+                    if (final_reward(winning_objective, gamestate) > 0) break;
+                    const action_type a = policy(gamestate, turn);
+                    if (a == Action::None) break;
+                    std::optional<State> next_state = gamestate.player_move(a);
+                    if (!next_state.has_value()) break;
+                    chunk_moves++;
+                    // Note: a valid move always leaves an empty tile
+                    gamestate = next_state.value().random_nature_move(generator).value();
+                }
+                chunk_wins += final_reward(winning_objective, gamestate) > 0;
+            }
+            wins += chunk_wins;
+            player_moves += chunk_moves;
+        });
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    SimulationResult result;
+    result.games = options.games;
+    result.wins = wins.load();
+    result.player_moves = player_moves.load();
+    result.seconds = elapsed.count();
+    return result;
+}
+
+}  // namespace BOARD_NAMESPACE
@@ -0,0 +1,164 @@
+#include "solution_file.hpp"
+#include "board_sizes.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// value table alignment in the file, so that mapped entries are aligned too
+constexpr uint64_t TABLE_ALIGNMENT = 64;
+
+uint64_t align_up(uint64_t offset) {
+    return (offset + TABLE_ALIGNMENT - 1) / TABLE_ALIGNMENT * TABLE_ALIGNMENT;
+}
+
+// Whether count entries of entry_bytes bytes from offset end by limit, without wrapping around
+bool range_fits(uint64_t offset, uint64_t count, uint64_t entry_bytes, uint64_t limit) {
+    return offset <= limit && count <= (limit - offset) / entry_bytes;
+}
+
+std::runtime_error file_error(const std::string& what, const std::string& path) {
+    return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+}  // namespace
+
+template <typename Storage>
+void save_solution(const std::string& path, SolutionHeader header,
+                   const Table<action_type>& policy, const Table<Storage>& value) {
+    if (policy.size() != value.size()) {
+        throw std::runtime_error("Policy and value tables of different sizes");
+    }
+    header.precision = static_cast<uint8_t>(ValueStorage<Storage>::PRECISION);
+    header.table_size = policy.size();
+    header.policy_offset = sizeof(SolutionHeader);
+    header.value_offset = align_up(header.policy_offset + policy.size() * sizeof(action_type));
+
+    const std::string temporary_path = path + ".tmp";
+    {
+        std::ofstream out(temporary_path, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            throw file_error("Cannot create", temporary_path);
+        }
+        const uint64_t policy_end = header.policy_offset + policy.size() * sizeof(action_type);
+        const std::vector<char> padding(header.value_offset - policy_end, 0);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(policy.data()), policy.size() * sizeof(action_type));
+        out.write(padding.data(), padding.size());
+        out.write(reinterpret_cast<const char*>(value.data()), value.size() * sizeof(Storage));
+        out.flush();
+        if (!out) {
+            std::remove(temporary_path.c_str());
+            throw file_error("Cannot write", temporary_path);
+        }
+    }
+    if (std::rename(temporary_path.c_str(), path.c_str()) != 0) {
+        std::remove(temporary_path.c_str());
+        throw file_error("Cannot rename to", path);
+    }
+}
+
+template void save_solution(const std::string&, SolutionHeader, const Table<action_type>&, const Table<double>&);
+template void save_solution(const std::string&, SolutionHeader, const Table<action_type>&, const Table<float>&);
+template void save_solution(const std::string&, SolutionHeader, const Table<action_type>&, const Table<Fixed16>&);
+template void save_solution(const std::string&, SolutionHeader, const Table<action_type>&, const Table<Quantized8>&);
+
+MappedSolution MappedSolution::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw file_error("Cannot open", path);
+    }
+    struct stat status;
+    if (::fstat(fd, &status) != 0) {
+        ::close(fd);
+        throw file_error("Cannot stat", path);
+    }
+    const size_t length = static_cast<size_t>(status.st_size);
+    if (length < sizeof(SolutionHeader)) {
+        ::close(fd);
+        throw std::runtime_error("Not a solution file: " + path);
+    }
+    // Note: shared read-only mapping, every process reading the file uses the same pages
+    void* data = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        throw file_error("Cannot map", path);
+    }
+
+    MappedSolution solution;
+    solution.data_ = data;
+    solution.length_ = length;
+
+    const SolutionHeader& header = solution.header();
+    const SolutionHeader expected;
+    if (std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0) {
+        throw std::runtime_error("Not a solution file: " + path);
+    }
+    if (header.byte_order != SolutionHeader::BYTE_ORDER_MARK) {
+        throw std::runtime_error("Solution file written with another byte order: " + path);
+    }
+    if (header.version != SolutionHeader::VERSION) {
+        throw std::runtime_error("Unsupported solution file version " + std::to_string(header.version)
+                                 + " (expected " + std::to_string(SolutionHeader::VERSION) + "): " + path);
+    }
+    if (!is_supported_board(static_cast<int>(header.rows), static_cast<int>(header.cols))) {
+        throw std::runtime_error("Solution file is for a " + std::to_string(header.rows) + "x"
+                                 + std::to_string(header.cols) + " board, this build plays "
+                                 + supported_boards() + ": " + path);
+    }
+    if (header.precision > static_cast<uint8_t>(ValuePrecision::Quantized8)) {
+        throw std::runtime_error("Unknown value encoding in solution file: " + path);
+    }
+    // Note: offsets and sizes come from the file, a corrupted header must not wrap past the checks
+    if (header.policy_offset < sizeof(SolutionHeader)
+        || !range_fits(header.policy_offset, header.table_size, sizeof(action_type), header.value_offset)
+        || header.value_offset % TABLE_ALIGNMENT != 0
+        || !range_fits(header.value_offset, header.table_size, value_bytes(solution.precision()), length)) {
+        throw std::runtime_error("Truncated or corrupted solution file: " + path);
+    }
+    // the game and the queries use actions as they are, one byte per entry to check
+    const uint8_t* policy = reinterpret_cast<const uint8_t*>(solution.policy());
+    if (std::any_of(policy, policy + header.table_size,
+                    [](uint8_t action) { return action > static_cast<uint8_t>(Action::None); })) {
+        throw std::runtime_error("Invalid action in solution file: " + path);
+    }
+    return solution;
+}
+
+MappedSolution::~MappedSolution() {
+    unmap();
+}
+
+MappedSolution::MappedSolution(MappedSolution&& other) noexcept
+    : data_(other.data_), length_(other.length_) {
+    other.data_ = nullptr;
+    other.length_ = 0;
+}
+
+MappedSolution& MappedSolution::operator=(MappedSolution&& other) noexcept {
+    if (this != &other) {
+        unmap();
+        data_ = other.data_;
+        length_ = other.length_;
+        other.data_ = nullptr;
+        other.length_ = 0;
+    }
+    return *this;
+}
+
+void MappedSolution::unmap() {
+    if (data_ != nullptr) {
+        ::munmap(data_, length_);
+        data_ = nullptr;
+        length_ = 0;
+    }
+}
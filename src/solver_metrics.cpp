@@ -0,0 +1,47 @@
+#include "solver_metrics.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <stdexcept>
+
+#include <sys/resource.h>
+
+int64_t peak_rss_bytes() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    // Note: ru_maxrss is in kilobytes on Linux
+    return static_cast<int64_t>(usage.ru_maxrss) * 1024;
+}
+
+MetricsWriter::MetricsWriter(const std::string& path) : path_(path), out_(path, std::ios::trunc) {
+    if (!out_) {
+        throw std::runtime_error("Cannot create " + path + ": " + std::strerror(errno));
+    }
+}
+
+void MetricsWriter::write(const StepMetrics& metrics) {
+    const SweepCounters& counters = metrics.counters;
+    out_ << "{\"time\":" << metrics.time
+         << ",\"step\":" << metrics.step
+         << ",\"seconds\":" << std::setprecision(6) << metrics.seconds
+         << ",\"states\":" << counters.states
+         << ",\"states_per_second\":" << std::setprecision(6)
+         << (metrics.seconds > 0 ? counters.states / metrics.seconds : 0)
+         << ",\"valid_moves\":" << counters.valid_moves
+         << ",\"successors\":" << counters.successors
+         << ",\"policy_changes\":" << counters.policy_changes
+         << ",\"peak_rss_bytes\":" << metrics.peak_rss_bytes;
+    if (metrics.max_change >= 0) {
+        out_ << ",\"max_change\":" << std::setprecision(17) << metrics.max_change;
+    }
+    if (metrics.worker_peak_rss_bytes >= 0) {
+        out_ << ",\"worker_peak_rss_bytes\":" << metrics.worker_peak_rss_bytes;
+    }
+    out_ << "}" << std::endl;
+    if (!out_) {
+        throw std::runtime_error("Cannot write " + path_);
+    }
+}
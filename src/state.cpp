@@ -1,11 +1,15 @@
 #include "state.hpp"
+#include "move_table.hpp"
 #include <iostream>
 #include <iomanip>
 #include <algorithm>
+#include <stdexcept>
+
+namespace BOARD_NAMESPACE {
 
 /*
 Class representing the game state on a board of dimensions ROWS x COLS,
-where ROWS and COLS are compile-time constants defined in CMakeLists.txt.
+where ROWS and COLS are compile-time constants, one build per size of BOARD_SIZES in CMakeLists.txt.
 */
 
 // Overloading () call for board_instance(i,j) access
@@ -17,7 +21,7 @@ int8_t State::operator()(int r, int c) const {
     return data_[r * State::COLS + c];
 }
 // Setting with non-const reference
-int8_t& State::operator()(int r, int c) {
+tile_reference State::operator()(int r, int c) {
     // Legacy implementation:
     // return this->data_[r][c];
     // Next implementation:
@@ -86,8 +90,9 @@ State::State(const std::vector<std::vector<int8_t>>& data) {
     }
     // Convert 2D vector to 1D array
     for (int i = 0; i < State::ROWS; ++i) {
-        int offset = i * State::COLS;
-        std::copy(data[i].begin(), data[i].end(), data_.begin() + offset);
+        for (int j = 0; j < State::COLS; ++j) {
+            (*this)(i, j) = data[i][j];
+        }
     }
 }
 
@@ -169,11 +174,181 @@ inline bool State::shift_right(int i, int j){
     return moved_non_zero_tile;
 }
 
+// Lookup tables for rows (moved Left/Right) and columns (moved Up/Down),
+// built on first use
+static const LineMoveTable<State::COLS>& row_move_table() {
+    static const LineMoveTable<State::COLS> table;
+    return table;
+}
+static const LineMoveTable<State::ROWS>& column_move_table() {
+    static const LineMoveTable<State::ROWS> table;
+    return table;
+}
+
+/*
+ * Moves every line of the board with one table lookup.
+ * A line is read from index first, stepping by stride, so that tiles move toward first.
+ * @returns false if a tile is too large for the table, state is then left unchanged
+ */
+template <int LENGTH>
+static inline bool move_lines(state_type& data, const LineMoveTable<LENGTH>& table,
+                              int lines, int first, int line_step, int stride,
+                              bool& is_valid_move) {
+    using Table = LineMoveTable<LENGTH>;
+    uint32_t keys[State::SIZE];
+    int8_t out_of_table = 0;
+    for (int line = 0; line < lines; line++) {
+        uint32_t key = 0;
+        for (int k = 0; k < LENGTH; k++) {
+            int8_t tile = data[first + line*line_step + k*stride];
+            out_of_table |= tile & ~Table::MAX_TILE;
+            key |= static_cast<uint32_t>(tile & Table::MAX_TILE) << (Table::TILE_BITS * k);
+        }
+        keys[line] = key;
+    }
+    if (out_of_table != 0) {
+        return false;
+    }
+    for (int line = 0; line < lines; line++) {
+        const auto& entry = table[keys[line]];
+        if (!entry.moved) continue;
+        is_valid_move = true;
+        for (int k = 0; k < LENGTH; k++) {
+            data[first + line*line_step + k*stride] = entry.tiles[k];
+        }
+    }
+    return true;
+}
+
+#ifdef PACKED_STATE
+// Packed board moves: lines are extracted with shifts and masks,
+// a line key is exactly the nibbles of the line in the order tiles move toward
+
+// Note: not an assert, Release builds would silently drop the merged tile
+[[noreturn]] static void throw_tile_overflow() {
+    throw std::overflow_error("Merging two 2^15 tiles does not fit in a packed board");
+}
+
+// Reverses the order of the LENGTH nibbles of a line
+template <int LENGTH>
+static inline uint32_t reverse_line(uint32_t line) {
+    uint32_t reversed = 0;
+    for (int k = 0; k < LENGTH; k++) {
+        reversed = (reversed << PackedBoard::TILE_BITS) | ((line >> (PackedBoard::TILE_BITS * k)) & PackedBoard::MAX_TILE);
+    }
+    return reversed;
+}
+
+// Left (toward column 0) or Right: a row is a contiguous group of nibbles
+static inline uint64_t move_rows(uint64_t bits, bool toward_first, bool& is_valid_move) {
+    constexpr int ROW_BITS = PackedBoard::TILE_BITS * State::COLS;
+    constexpr uint64_t ROW_MASK = (1ULL << ROW_BITS) - 1;
+    const auto& table = row_move_table();
+    uint64_t out = bits;
+    for (int i = 0; i < State::ROWS; i++) {
+        uint32_t row = static_cast<uint32_t>((bits >> (ROW_BITS * i)) & ROW_MASK);
+        const auto& entry = table[toward_first ? row : reverse_line<State::COLS>(row)];
+        if (!entry.moved) continue;
+        if (entry.overflows) throw_tile_overflow();
+        is_valid_move = true;
+        uint64_t new_row = toward_first ? entry.packed : reverse_line<State::COLS>(entry.packed);
+        out = (out & ~(ROW_MASK << (ROW_BITS * i))) | (new_row << (ROW_BITS * i));
+    }
+    return out;
+}
+
+// Up (toward row 0) or Down: a column is gathered one nibble per row
+static inline uint64_t move_columns(uint64_t bits, bool toward_first, bool& is_valid_move) {
+    constexpr int TILE_BITS = PackedBoard::TILE_BITS;
+    const auto& table = column_move_table();
+    uint64_t out = bits;
+    for (int j = 0; j < State::COLS; j++) {
+        uint32_t key = 0;
+        for (int k = 0; k < State::ROWS; k++) {
+            int i = toward_first ? k : State::ROWS-1-k;
+            key |= static_cast<uint32_t>((bits >> (TILE_BITS * (i*State::COLS + j))) & PackedBoard::MAX_TILE) << (TILE_BITS * k);
+        }
+        const auto& entry = table[key];
+        if (!entry.moved) continue;
+        if (entry.overflows) throw_tile_overflow();
+        is_valid_move = true;
+        for (int k = 0; k < State::ROWS; k++) {
+            int i = toward_first ? k : State::ROWS-1-k;
+            int shift = TILE_BITS * (i*State::COLS + j);
+            uint64_t tile = (entry.packed >> (TILE_BITS * k)) & PackedBoard::MAX_TILE;
+            out = (out & ~(uint64_t(PackedBoard::MAX_TILE) << shift)) | (tile << shift);
+        }
+    }
+    return out;
+}
+
+std::optional<State> State::player_move(action_type a) const {
+    // Note: merging two 2^15 tiles cannot be represented, it throws std::overflow_error
+    // (parse_cli keeps objectives of packed builds at 2^14, whose merges still fit)
+    bool is_valid_move = false;
+    uint64_t bits = data_.bits();
+    switch (a)
+    {
+    case Action::Up:    bits = move_columns(bits, true, is_valid_move); break;
+    case Action::Down:  bits = move_columns(bits, false, is_valid_move); break;
+    case Action::Left:  bits = move_rows(bits, true, is_valid_move); break;
+    case Action::Right: bits = move_rows(bits, false, is_valid_move); break;
+    default: break;
+    }
+    if (!is_valid_move) {
+        return std::nullopt;
+    }
+    State state_new;
+    state_new.data_.set_bits(bits);
+    return state_new;
+}
+#else
 // this part of a move is deterministic and is independent of Nature move
 // revision: no longer changes gamestate
+// revision: one table lookup per row or column instead of shifting tiles
 std::optional<State> State::player_move(action_type a) const {
     State state_new = *this; // copies current gamestate to explore the move
 
+    bool is_valid_move = false;
+    bool in_table = true;
+    switch (a)
+    {
+    case Action::Up:
+        // columns, read from top row downward
+        in_table = move_lines(state_new.data_, column_move_table(), State::COLS,
+                              0, 1, State::COLS, is_valid_move);
+        break;
+    case Action::Down:
+        // columns, read from bottom row upward
+        in_table = move_lines(state_new.data_, column_move_table(), State::COLS,
+                              (State::ROWS-1)*State::COLS, 1, -State::COLS, is_valid_move);
+        break;
+    case Action::Left:
+        // rows, read from left column rightward
+        in_table = move_lines(state_new.data_, row_move_table(), State::ROWS,
+                              0, State::COLS, 1, is_valid_move);
+        break;
+    case Action::Right:
+        // rows, read from right column leftward
+        in_table = move_lines(state_new.data_, row_move_table(), State::ROWS,
+                              State::COLS-1, State::COLS, -1, is_valid_move);
+        break;
+
+    default:
+        break;
+    }
+
+    if (!in_table) {
+        // tiles above 2^15 never happen on our boards, but stay exact if they do
+        return player_move_legacy(a);
+    }
+    return is_valid_move? std::optional<State>(state_new) : std::nullopt;
+}
+#endif
+
+std::optional<State> State::player_move_legacy(action_type a) const {
+    State state_new = *this; // copies current gamestate to explore the move
+
     bool is_valid_move = false;
     switch (a)
     {
@@ -331,9 +506,20 @@ std::optional<State> State::player_move(action_type a) const {
 
 
 std::vector<Coord> State::all_nature_moves() const {
+    std::vector<Coord> list_of_empty_tiles;
+#ifdef PACKED_STATE
+    // walk the set bits of the empty mask, in the same order as the loop below
+    uint64_t empty = data_.empty_mask();
+    list_of_empty_tiles.reserve(__builtin_popcountll(empty));
+    while (empty != 0) {
+        int index = __builtin_ctzll(empty) / PackedBoard::TILE_BITS;
+        list_of_empty_tiles.push_back({index / State::COLS, index % State::COLS});
+        empty &= empty - 1;
+    }
+    return list_of_empty_tiles;
+#else
     int rows = State::ROWS;
     int cols = State::COLS;
-    std::vector<Coord> list_of_empty_tiles;
     for (int i = 0; i < rows; i++)
     {
         for (int j = 0; j < cols; j++)
@@ -346,23 +532,53 @@ std::vector<Coord> State::all_nature_moves() const {
     }
 
     return list_of_empty_tiles;
+#endif
+}
+
+int State::count_empty_tiles() const {
+#ifdef PACKED_STATE
+    return data_.count_empty();
+#else
+    int empty = 0;
+    for (int i = 0; i < State::SIZE; i++) {
+        empty += data_[i] == 0;
+    }
+    return empty;
+#endif
 }
 
 std::optional<State> State::random_nature_move() const{
-    std::vector<Coord> list_of_empty_tiles = State::all_nature_moves();
+    // Note: one generator per thread, seeded once, instead of reseeding rand() on every move
+    thread_local util::Xoshiro256 generator(std::random_device{}());
+    return random_nature_move(generator);
+}
+
+std::optional<State> State::random_nature_move(util::Xoshiro256& generator) const {
+    const int empty_tiles = count_empty_tiles();
     // Nature move is valid if there are still available tiles
-    bool is_valid_move = list_of_empty_tiles.size()>0;
-    
-    
-    if (is_valid_move)
-    {
-        State new_state = *this;
-        srand((unsigned) time(NULL) + list_of_empty_tiles.size()); 
-        Coord chosen_square = list_of_empty_tiles[rand()%list_of_empty_tiles.size()];
-        int8_t new_value = rand()%2 + 1;
+    if (empty_tiles == 0) {
+        return std::nullopt;
+    }
+    // one draw for both the tile and its value, each of the 2n moves is equally likely
+    const uint32_t draw = generator.below(2 * empty_tiles);
+    int skipped = static_cast<int>(draw / 2);
+    const int8_t new_value = static_cast<int8_t>(draw % 2 + 1);
 
-        new_state(chosen_square.i, chosen_square.j) = new_value;
-        return std::optional<State>(new_state);
+    State new_state = *this;
+#ifdef PACKED_STATE
+    uint64_t empty = data_.empty_mask();
+    for (; skipped > 0; skipped--) {
+        empty &= empty - 1;
+    }
+    const int index = __builtin_ctzll(empty) / PackedBoard::TILE_BITS;
+#else
+    int index = 0;
+    while (data_[index] != 0 || skipped-- > 0) {
+        index++;
     }
-    else return std::nullopt;
-}
\ No newline at end of file
+#endif
+    new_state(index / State::COLS, index % State::COLS) = new_value;
+    return new_state;
+}
+
+}  // namespace BOARD_NAMESPACE
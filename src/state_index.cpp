@@ -0,0 +1,246 @@
+#include "state_index.hpp"
+#include "state.hpp"
+#include "utils.hpp"
+#include "symmetry.hpp"
+#include "successor_kernel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace BOARD_NAMESPACE {
+
+namespace {
+
+// Frontier boards (or bitset words) handed to a thread at a time
+constexpr int64_t BFS_CHUNK_SIZE = 1024;
+
+/*
+ * Breadth-first search over Nature and player moves from the empty board:
+ * mark(hash) is called from several threads at once for every board found,
+ * and returns true the first time it sees a board
+ */
+template <typename Mark>
+void breadth_first_search(int winning_objective, util::ThreadPool& pool, Mark&& mark) {
+    // the game starts on the empty board, followed by a Nature move
+    std::vector<int64_t> frontier = {0};
+    mark(0);
+
+    std::mutex next_frontier_mutex;
+    while (!frontier.empty()) {
+        std::vector<int64_t> next_frontier;
+        pool.parallel_for(0, static_cast<int64_t>(frontier.size()), BFS_CHUNK_SIZE,
+            [&](int64_t chunk_begin, int64_t chunk_end) {
+                std::vector<int64_t> discovered;
+                auto visit = [&](int64_t hash) {
+                    if (mark(hash)) discovered.push_back(hash);
+                };
+
+                // Note: frontier boards are not consecutive, the kernel decodes each of them
+                SuccessorKernel kernel(winning_objective);
+                int64_t successors[SuccessorKernel::MAX_SUCCESSORS];
+                for (int64_t k = chunk_begin; k < chunk_end; k++) {
+                    const State& gamestate = kernel.seek(frontier[k]);
+                    if (frontier[k] == 0) {
+                        // empty board: no player move, Nature places the first tile
+                        const int length = kernel.nature_successors(gamestate, 0, successors);
+                        for (int n = 0; n < length; n++) visit(successors[n]);
+                        continue;
+                    }
+                    // None keeps the same board, only the other actions lead to new boards
+                    for (auto a : Actions::All) {
+                        if (a == Action::None) continue;
+                        const int length = kernel.successors(a, successors);
+                        for (int n = 0; n < length; n++) visit(successors[n]);
+                    }
+                }
+
+                std::lock_guard<std::mutex> lock(next_frontier_mutex);
+                next_frontier.insert(next_frontier.end(), discovered.begin(), discovered.end());
+            });
+        frontier.swap(next_frontier);
+    }
+}
+
+}  // namespace
+
+ReachableIndex ReachableIndex::build(int winning_objective, util::ThreadPool& pool) {
+    ReachableIndex index;
+    const int64_t total_combinations = state_space_size(winning_objective);
+    const int64_t words = (total_combinations + 63) / 64;
+
+    // Note: value-initialised, ie all zero
+    std::unique_ptr<std::atomic<uint64_t>[]> visited(new std::atomic<uint64_t>[words]());
+    breadth_first_search(winning_objective, pool, [&](int64_t hash) {
+        uint64_t bit = uint64_t(1) << (hash & 63);
+        return (visited[hash >> 6].fetch_or(bit, std::memory_order_relaxed) & bit) == 0;
+    });
+
+    // rank directory and sorted list of reachable hashes
+    std::vector<uint64_t> bits(words);
+    for (int64_t w = 0; w < words; w++) {
+        bits[w] = visited[w].load(std::memory_order_relaxed);
+    }
+    visited.reset();
+
+    index.members_ = RankedBitset(total_combinations, std::move(bits));
+    index.hashes_ = index.members_.set_hashes(pool);
+    return index;
+}
+
+size_t ReachableIndex::memory_bytes() const {
+    return members_.memory_bytes() + hashes_.size() * sizeof(int64_t);
+}
+
+SparseIndex SparseIndex::build(int winning_objective, util::ThreadPool& pool) {
+    SparseIndex index;
+    index.total_combinations_ = state_space_size(winning_objective);
+    // smallest ranges of hashes that need at most SHARDS shards
+    while (((index.total_combinations_ - 1) >> index.shard_shift_) >= SHARDS) {
+        index.shard_shift_++;
+    }
+    const int64_t shards = ((index.total_combinations_ - 1) >> index.shard_shift_) + 1;
+    index.shards_.resize(shards);
+
+    // the search inserts boards in the shards under their lock
+    std::unique_ptr<std::mutex[]> locks(new std::mutex[shards]);
+    std::vector<int64_t> counts(shards, 0);
+    breadth_first_search(winning_objective, pool, [&](int64_t hash) {
+        const int64_t s = hash >> index.shard_shift_;
+        Shard& shard = index.shards_[s];
+        std::lock_guard<std::mutex> lock(locks[s]);
+        if (2 * (counts[s] + 1) > static_cast<int64_t>(shard.entries.size())) {
+            resize(shard, std::max<size_t>(16, 2 * shard.entries.size()));
+        }
+        for (uint64_t slot = slot_of(hash) & shard.mask;; slot = (slot + 1) & shard.mask) {
+            Entry& entry = shard.entries[slot];
+            if (entry.hash == hash) return false;
+            if (entry.hash == EMPTY) {
+                entry.hash = hash;
+                counts[s]++;
+                return true;
+            }
+        }
+    });
+
+    // shards are increasing ranges of hashes: sorting each one sorts them all
+    std::vector<int64_t> offsets(shards + 1, 0);
+    for (int64_t s = 0; s < shards; s++) {
+        offsets[s + 1] = offsets[s] + counts[s];
+    }
+    index.hashes_.resize(offsets[shards]);
+    pool.parallel_for(0, shards, 1, [&](int64_t chunk_begin, int64_t chunk_end) {
+        for (int64_t s = chunk_begin; s < chunk_end; s++) {
+            Shard& shard = index.shards_[s];
+            int64_t* hashes = index.hashes_.data() + offsets[s];
+            int64_t* out = hashes;
+            for (const Entry& entry : shard.entries) {
+                if (entry.hash != EMPTY) *out++ = entry.hash;
+            }
+            std::sort(hashes, out);
+
+            // read-only table of (hash, position), at most half full
+            size_t capacity = 16;
+            while (capacity < 2 * static_cast<size_t>(counts[s])) capacity *= 2;
+            Shard sorted;
+            sorted.entries.assign(counts[s] > 0 ? capacity : 0, Entry{EMPTY, EMPTY});
+            sorted.mask = capacity - 1;
+            for (int64_t k = 0; k < counts[s]; k++) {
+                uint64_t slot = slot_of(hashes[k]) & sorted.mask;
+                while (sorted.entries[slot].hash != EMPTY) slot = (slot + 1) & sorted.mask;
+                sorted.entries[slot] = Entry{hashes[k], offsets[s] + k};
+            }
+            shard = std::move(sorted);
+        }
+    });
+    return index;
+}
+
+void SparseIndex::resize(Shard& shard, size_t capacity) {
+    Shard resized;
+    resized.entries.assign(capacity, Entry{EMPTY, EMPTY});
+    resized.mask = capacity - 1;
+    for (const Entry& entry : shard.entries) {
+        if (entry.hash == EMPTY) continue;
+        uint64_t slot = slot_of(entry.hash) & resized.mask;
+        while (resized.entries[slot].hash != EMPTY) slot = (slot + 1) & resized.mask;
+        resized.entries[slot] = entry;
+    }
+    shard = std::move(resized);
+}
+
+size_t SparseIndex::memory_bytes() const {
+    size_t bytes = shards_.size() * sizeof(Shard) + hashes_.size() * sizeof(int64_t);
+    for (const Shard& shard : shards_) {
+        bytes += shard.entries.size() * sizeof(Entry);
+    }
+    return bytes;
+}
+
+SymmetricIndex SymmetricIndex::build(int winning_objective, util::ThreadPool& pool,
+                                     const ReachableIndex* reachable) {
+    SymmetricIndex index;
+    index.winning_objective_ = winning_objective;
+    const int64_t total_combinations = state_space_size(winning_objective);
+    const int64_t candidates = reachable != nullptr ? reachable->size() : total_combinations;
+    auto candidate_hash = [&](int64_t k) { return reachable != nullptr ? reachable->hash_at(k) : k; };
+
+    // canonical flag of every candidate, then packed into bits serially
+    std::vector<uint8_t> canonical(candidates);
+    pool.parallel_for(0, candidates, BFS_CHUNK_SIZE,
+        [&](int64_t chunk_begin, int64_t chunk_end) {
+            for (int64_t k = chunk_begin; k < chunk_end; k++) {
+                int64_t hash = candidate_hash(k);
+                canonical[k] = canonical_hash(winning_objective, hash).hash == hash;
+            }
+        });
+
+    std::vector<uint64_t> bits((total_combinations + 63) / 64);
+    for (int64_t k = 0; k < candidates; k++) {
+        if (canonical[k]) {
+            int64_t hash = candidate_hash(k);
+            bits[hash >> 6] |= uint64_t(1) << (hash & 63);
+        }
+    }
+
+    index.members_ = RankedBitset(total_combinations, std::move(bits));
+    index.hashes_ = index.members_.set_hashes(pool);
+    return index;
+}
+
+int64_t SymmetricIndex::position(int64_t hash) const {
+    return members_.rank(canonical_hash(winning_objective_, hash).hash);
+}
+
+size_t SymmetricIndex::memory_bytes() const {
+    return members_.memory_bytes() + hashes_.size() * sizeof(int64_t);
+}
+
+RankedBitset::RankedBitset(int64_t total, std::vector<uint64_t> bits)
+    : total_(total), bits_(std::move(bits)), word_ranks_(bits_.size() + 1) {
+    word_ranks_[0] = 0;
+    for (size_t w = 0; w < bits_.size(); w++) {
+        word_ranks_[w + 1] = word_ranks_[w] + __builtin_popcountll(bits_[w]);
+    }
+}
+
+std::vector<int64_t> RankedBitset::set_hashes(util::ThreadPool& pool) const {
+    std::vector<int64_t> hashes(count());
+    pool.parallel_for(0, static_cast<int64_t>(bits_.size()), BFS_CHUNK_SIZE,
+        [&](int64_t chunk_begin, int64_t chunk_end) {
+            for (int64_t w = chunk_begin; w < chunk_end; w++) {
+                int64_t* out = hashes.data() + word_ranks_[w];
+                for (uint64_t word = bits_[w]; word != 0; word &= word - 1) {
+                    *out++ = w * 64 + __builtin_ctzll(word);
+                }
+            }
+        });
+    return hashes;
+}
+
+size_t RankedBitset::memory_bytes() const {
+    return bits_.size() * sizeof(uint64_t) + word_ranks_.size() * sizeof(uint64_t);
+}
+
+}  // namespace BOARD_NAMESPACE
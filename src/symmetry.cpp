@@ -0,0 +1,113 @@
+#include "symmetry.hpp"
+#include "utils.hpp"
+
+namespace BOARD_NAMESPACE {
+
+namespace {
+
+// Flat index a tile at (r, c) is moved to by g
+constexpr int destination(Symmetry g, int r, int c) {
+    constexpr int ROWS = State::ROWS;
+    constexpr int COLS = State::COLS;
+    // Note: only reached for square boards, where ROWS == COLS
+    constexpr int n = State::ROWS;
+    switch (g) {
+    case Symmetry::Identity:      return r * COLS + c;
+    case Symmetry::FlipRows:      return (ROWS-1-r) * COLS + c;
+    case Symmetry::FlipColumns:   return r * COLS + (COLS-1-c);
+    case Symmetry::Rotate180:     return (ROWS-1-r) * COLS + (COLS-1-c);
+    case Symmetry::Transpose:     return c * COLS + r;
+    case Symmetry::AntiTranspose: return (n-1-c) * COLS + (n-1-r);
+    case Symmetry::Rotate90:      return c * COLS + (n-1-r);
+    case Symmetry::Rotate270:     return (n-1-c) * COLS + r;
+    }
+    return r * COLS + c;
+}
+
+// destinations[g][i]: flat index tile i is moved to by g
+struct DestinationTable {
+    std::array<std::array<int, State::SIZE>, 8> destinations{};
+    constexpr DestinationTable() {
+        for (int g = 0; g < Symmetries::COUNT; g++) {
+            for (int r = 0; r < State::ROWS; r++) {
+                for (int c = 0; c < State::COLS; c++) {
+                    destinations[g][r * State::COLS + c] = destination(Symmetry(g), r, c);
+                }
+            }
+        }
+    }
+};
+constexpr DestinationTable DESTINATIONS;
+
+}  // namespace
+
+Symmetry inverse(Symmetry g) {
+    switch (g) {
+    case Symmetry::Rotate90:  return Symmetry::Rotate270;
+    case Symmetry::Rotate270: return Symmetry::Rotate90;
+    default:                  return g;  // all other symmetries are involutions
+    }
+}
+
+State apply(Symmetry g, const State& gamestate) {
+    const auto& destinations = DESTINATIONS.destinations[static_cast<int>(g)];
+    State transformed;
+    for (int i = 0; i < State::SIZE; i++) {
+        int d = destinations[i];
+        transformed(d / State::COLS, d % State::COLS) = gamestate(i / State::COLS, i % State::COLS);
+    }
+    return transformed;
+}
+
+action_type apply(Symmetry g, action_type a) {
+    // Rows of the table follow Symmetry, columns follow Up, Down, Left, Right
+    static constexpr Action moved[8][4] = {
+        {Action::Up,    Action::Down,  Action::Left,  Action::Right},  // Identity
+        {Action::Down,  Action::Up,    Action::Left,  Action::Right},  // FlipRows
+        {Action::Up,    Action::Down,  Action::Right, Action::Left},   // FlipColumns
+        {Action::Down,  Action::Up,    Action::Right, Action::Left},   // Rotate180
+        {Action::Left,  Action::Right, Action::Up,    Action::Down},   // Transpose
+        {Action::Right, Action::Left,  Action::Down,  Action::Up},     // AntiTranspose
+        {Action::Right, Action::Left,  Action::Up,    Action::Down},   // Rotate90
+        {Action::Left,  Action::Right, Action::Down,  Action::Up},     // Rotate270
+    };
+    if (a == Action::None) {
+        return Action::None;
+    }
+    return moved[static_cast<int>(g)][static_cast<int>(a)];
+}
+
+CanonicalBoard canonical_hash(int winning_objective, int64_t hash) {
+    const int64_t base = winning_objective + 1;
+
+    // digits of the hash, ie (clamped) tiles
+    std::array<int64_t, State::SIZE> tiles;
+    for (int i = 0; i < State::SIZE; i++) {
+        tiles[i] = hash % base;
+        hash /= base;
+    }
+    std::array<int64_t, State::SIZE> place_values;
+    place_values[0] = 1;
+    for (int i = 1; i < State::SIZE; i++) {
+        place_values[i] = place_values[i-1] * base;
+    }
+
+    CanonicalBoard canonical = {-1, Symmetry::Identity};
+    for (int g = 0; g < Symmetries::COUNT; g++) {
+        const auto& destinations = DESTINATIONS.destinations[g];
+        int64_t transformed = 0;
+        for (int i = 0; i < State::SIZE; i++) {
+            transformed += tiles[i] * place_values[destinations[i]];
+        }
+        if (canonical.hash < 0 || transformed < canonical.hash) {
+            canonical = {transformed, Symmetry(g)};
+        }
+    }
+    return canonical;
+}
+
+CanonicalBoard canonical_hash(int winning_objective, const State& gamestate) {
+    return canonical_hash(winning_objective, gamestate_to_hash(winning_objective, gamestate));
+}
+
+}  // namespace BOARD_NAMESPACE
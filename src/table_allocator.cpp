@@ -0,0 +1,219 @@
+#include "table_allocator.hpp"
+
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <sys/mman.h>
+
+namespace util {
+
+namespace {
+
+constexpr size_t SMALL_PAGE_BYTES = 4096;
+
+size_t round_up(size_t bytes, size_t alignment) {
+    return (bytes + alignment - 1) / alignment * alignment;
+}
+
+void* map_explicit(size_t length) {
+    void* data = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    return data == MAP_FAILED ? nullptr : data;
+}
+
+// Note: transparent huge pages are only used for 2 MiB aligned ranges,
+// the mapping is made one huge page longer and trimmed to an aligned start
+void* map_aligned(size_t length) {
+    void* data = mmap(nullptr, length + HUGE_PAGE_BYTES, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data == MAP_FAILED) {
+        return nullptr;
+    }
+    const uintptr_t start = reinterpret_cast<uintptr_t>(data);
+    const uintptr_t aligned = round_up(start, HUGE_PAGE_BYTES);
+    if (aligned > start) {
+        munmap(data, aligned - start);
+    }
+    const size_t tail = start + HUGE_PAGE_BYTES - aligned;
+    if (tail > 0) {
+        munmap(reinterpret_cast<char*>(aligned + length), tail);
+    }
+    return reinterpret_cast<void*>(aligned);
+}
+
+// One contiguous block of pages per thread
+void first_touch(char* data, size_t length, int threads) {
+    const int64_t pages = length / SMALL_PAGE_BYTES;
+    ThreadPool pool(threads);
+    const int64_t block = (pages + pool.size() - 1) / pool.size();
+    pool.parallel_for(0, pages, block, [data](int64_t begin, int64_t end) {
+        for (int64_t page = begin; page < end; page++) {
+            data[page * SMALL_PAGE_BYTES] = 0;
+        }
+    });
+}
+
+// Value of "key: N kB" lines of smaps, in bytes
+size_t kilobytes_field(const std::string& line, const std::string& key) {
+    if (line.compare(0, key.size(), key) != 0) {
+        return 0;
+    }
+    return std::stoull(line.substr(key.size())) * 1024;
+}
+
+}  // namespace
+
+std::string to_string(HugePages pages) {
+    switch (pages) {
+    case HugePages::Auto:        return "auto";
+    case HugePages::Explicit:    return "explicit";
+    case HugePages::Transparent: return "transparent";
+    case HugePages::Off:         return "off";
+    }
+    return "unknown";
+}
+
+HugePages parse_huge_pages(const std::string& name) {
+    for (HugePages pages : {HugePages::Auto, HugePages::Explicit, HugePages::Transparent, HugePages::Off}) {
+        if (name == to_string(pages)) {
+            return pages;
+        }
+    }
+    throw std::invalid_argument("Unknown huge pages mode: " + name + " (auto, explicit, transparent or off)");
+}
+
+void* allocate_table(size_t bytes, const TableOptions& options) {
+    if (bytes < HUGE_PAGE_BYTES) {
+        void* data = std::calloc(bytes, 1);
+        if (data == nullptr) {
+            throw std::bad_alloc();
+        }
+        return data;
+    }
+    const size_t length = round_up(bytes, HUGE_PAGE_BYTES);
+    void* data = nullptr;
+    // Note: without enough reserved pages the mapping fails right away, transparent pages take over
+    if (options.huge_pages == HugePages::Auto || options.huge_pages == HugePages::Explicit) {
+        data = map_explicit(length);
+    }
+    if (data == nullptr) {
+        data = map_aligned(length);
+        if (data == nullptr) {
+            throw std::bad_alloc();
+        }
+        madvise(data, length, options.huge_pages == HugePages::Off ? MADV_NOHUGEPAGE : MADV_HUGEPAGE);
+    }
+    first_touch(static_cast<char*>(data), length, options.threads);
+    return data;
+}
+
+void free_table(void* data, size_t bytes) {
+    if (bytes < HUGE_PAGE_BYTES) {
+        std::free(data);
+        return;
+    }
+    munmap(data, round_up(bytes, HUGE_PAGE_BYTES));
+}
+
+void release_table_pages(void* data, size_t bytes) {
+    if (bytes < HUGE_PAGE_BYTES) {
+        return;
+    }
+    // Note: explicit huge pages are only released by recent kernels, elsewhere the table keeps them
+    madvise(data, round_up(bytes, HUGE_PAGE_BYTES), MADV_DONTNEED);
+}
+
+TablePlacement table_placement(const void* data, size_t bytes) {
+    TablePlacement placement;
+    placement.bytes = bytes;
+    const uintptr_t begin = reinterpret_cast<uintptr_t>(data);
+    const uintptr_t end = begin + bytes;
+
+    // Note: the kernel merges neighbouring mappings with the same flags, counts of a mapping
+    // that extends past the table are scaled by the share of the table in it
+    std::map<uintptr_t, double> share_of_mapping;
+    std::ifstream smaps("/proc/self/smaps");
+    std::string line;
+    double share = 0;
+    while (std::getline(smaps, line)) {
+        uintptr_t mapping_begin = 0;
+        uintptr_t mapping_end = 0;
+        char dash = 0;
+        std::istringstream header(line);
+        if (header >> std::hex >> mapping_begin >> dash >> mapping_end && dash == '-') {
+            const uintptr_t overlap_begin = std::max(begin, mapping_begin);
+            const uintptr_t overlap_end = std::min(end, mapping_end);
+            share = overlap_end > overlap_begin ? double(overlap_end - overlap_begin) / (mapping_end - mapping_begin) : 0;
+            if (share > 0) {
+                share_of_mapping[mapping_begin] = share;
+            }
+            continue;
+        }
+        if (share == 0) {
+            continue;
+        }
+        const size_t explicit_bytes = kilobytes_field(line, "Private_Hugetlb:") + kilobytes_field(line, "Shared_Hugetlb:");
+        placement.explicit_huge_pages |= explicit_bytes > 0;
+        placement.huge_bytes += share * (explicit_bytes + kilobytes_field(line, "AnonHugePages:")
+                                         + kilobytes_field(line, "ShmemPmdMapped:"));
+    }
+    placement.huge_bytes = std::min(placement.huge_bytes, bytes);
+
+    // lines of numa_maps: start address, policy, then key=value fields such as N0=pages
+    std::map<int, size_t> node_bytes;
+    std::ifstream numa_maps("/proc/self/numa_maps");
+    while (std::getline(numa_maps, line)) {
+        std::istringstream fields(line);
+        uintptr_t mapping_begin = 0;
+        if (!(fields >> std::hex >> mapping_begin) || share_of_mapping.count(mapping_begin) == 0) {
+            continue;
+        }
+        std::map<int, size_t> pages;
+        size_t page_bytes = SMALL_PAGE_BYTES;
+        std::string field;
+        while (fields >> field) {
+            if (field.size() > 1 && field[0] == 'N' && field.find('=') != std::string::npos) {
+                pages[std::stoi(field.substr(1))] += std::stoull(field.substr(field.find('=') + 1));
+            } else if (field.compare(0, 17, "kernelpagesize_kB") == 0) {
+                page_bytes = std::stoull(field.substr(18)) * 1024;
+            }
+        }
+        for (const auto& [node, count] : pages) {
+            node_bytes[node] += share_of_mapping[mapping_begin] * count * page_bytes;
+        }
+    }
+    // Note: pages of a shared mapping only count in the processes that touched them
+    for (const auto& [node, bytes] : node_bytes) {
+        if (bytes > 0) {
+            placement.node_bytes.emplace_back(node, bytes);
+        }
+    }
+    return placement;
+}
+
+std::string to_string(const TablePlacement& placement) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1) << placement.bytes / (1024.0 * 1024.0) << " MiB, ";
+    if (placement.bytes < HUGE_PAGE_BYTES) {
+        out << "small table";
+    } else if (placement.huge_bytes == 0) {
+        out << "no huge pages";
+    } else {
+        out << placement.huge_bytes / HUGE_PAGE_BYTES << " huge pages ("
+            << (placement.explicit_huge_pages ? "explicit" : "transparent") << ", "
+            << 100.0 * placement.huge_bytes / placement.bytes << "%)";
+    }
+    if (!placement.node_bytes.empty()) {
+        out << ", nodes";
+        for (const auto& [node, bytes] : placement.node_bytes) {
+            out << " N" << node << "=" << 100.0 * bytes / placement.bytes << "%";
+        }
+    }
+    return out.str();
+}
+
+}
@@ -0,0 +1,100 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+
+namespace util {
+
+int ThreadPool::default_threads() {
+    unsigned int hardware = std::thread::hardware_concurrency();
+    // hardware_concurrency is allowed to return 0 when it cannot tell
+    return hardware > 0 ? static_cast<int>(hardware) : 1;
+}
+
+ThreadPool::ThreadPool(int threads) {
+    if (threads <= 0) {
+        threads = default_threads();
+    }
+    // the calling thread also takes part in every parallel_for
+    for (int i = 0; i < threads - 1; i++) {
+        workers_.emplace_back(&ThreadPool::worker_loop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        shutting_down_ = true;
+    }
+    work_ready_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::run_chunks() {
+    while (true) {
+        int64_t chunk_begin = next_chunk_.fetch_add(chunk_size_, std::memory_order_relaxed);
+        if (chunk_begin >= end_) {
+            return;
+        }
+        int64_t chunk_end = std::min(chunk_begin + chunk_size_, end_);
+        (*body_)(chunk_begin, chunk_end);
+    }
+}
+
+void ThreadPool::worker_loop() {
+    uint64_t seen_generation = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_ready_.wait(lock, [&] { return shutting_down_ || generation_ != seen_generation; });
+            if (shutting_down_) {
+                return;
+            }
+            seen_generation = generation_;
+        }
+
+        run_chunks();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            busy_workers_--;
+        }
+        work_done_.notify_one();
+    }
+}
+
+void ThreadPool::parallel_for(int64_t begin, int64_t end, int64_t chunk_size, const ChunkFunction& body) {
+    if (begin >= end) {
+        return;
+    }
+    chunk_size = std::max<int64_t>(chunk_size, 1);
+
+    // single thread: no synchronisation needed, keeps the serial path cheap
+    if (workers_.empty()) {
+        for (int64_t chunk_begin = begin; chunk_begin < end; chunk_begin += chunk_size) {
+            body(chunk_begin, std::min(chunk_begin + chunk_size, end));
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        body_ = &body;
+        end_ = end;
+        chunk_size_ = chunk_size;
+        next_chunk_.store(begin, std::memory_order_relaxed);
+        busy_workers_ = static_cast<int>(workers_.size());
+        generation_++;
+    }
+    work_ready_.notify_all();
+
+    // the caller works as well instead of waiting idle
+    run_chunks();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    work_done_.wait(lock, [&] { return busy_workers_ == 0; });
+    body_ = nullptr;
+}
+
+}
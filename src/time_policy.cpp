@@ -0,0 +1,236 @@
+#include "time_policy.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+std::runtime_error file_error(const std::string& what, const std::string& path) {
+    return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+}  // namespace
+
+TimePolicyWriter::TimePolicyWriter(const std::string& path, int64_t table_size, int first_time,
+                                   const util::TableOptions& table_options)
+    : path_(path), temporary_path_(path + ".tmp"),
+      pending_(util::TableAllocator<action_type>(table_options)),
+      previous_(util::TableAllocator<action_type>(table_options)) {
+    header_.table_size = table_size;
+    header_.block_entries = BLOCK_ENTRIES;
+    header_.first_time = first_time;
+    header_.blocks_offset = sizeof(TimePolicyHeader);
+    words_.resize(header_.block_words());
+    pending_.resize(table_size);
+    previous_.resize(table_size);
+
+    // the header is written again by finish, once the sizes are known
+    out_.open(temporary_path_, std::ios::binary | std::ios::trunc);
+    out_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+    if (!out_) {
+        throw file_error("Cannot create", temporary_path_);
+    }
+    thread_ = std::thread(&TimePolicyWriter::writer_loop, this);
+}
+
+TimePolicyWriter::~TimePolicyWriter() {
+    if (thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closing_ = true;
+        }
+        changed_.notify_all();
+        thread_.join();
+        out_.close();
+        std::remove(temporary_path_.c_str());
+    }
+}
+
+void TimePolicyWriter::add_step(const action_type* policy) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    changed_.wait(lock, [&] { return !has_pending_; });
+    if (!error_.empty()) {
+        throw std::runtime_error(error_);
+    }
+    std::copy(policy, policy + header_.table_size, pending_.begin());
+    has_pending_ = true;
+    changed_.notify_all();
+}
+
+void TimePolicyWriter::writer_loop() {
+    while (true) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        changed_.wait(lock, [&] { return has_pending_ || closing_; });
+        if (!has_pending_) {
+            return;
+        }
+        // Note: add_step does not touch the tables until has_pending_ is reset
+        lock.unlock();
+        std::string error;
+        if (error_.empty()) {
+            try {
+                write_step();
+            } catch (const std::runtime_error& e) {
+                error = e.what();
+            }
+        }
+        lock.lock();
+        pending_.swap(previous_);
+        has_pending_ = false;
+        if (!error.empty()) {
+            error_ = error;
+        }
+        changed_.notify_all();
+    }
+}
+
+void TimePolicyWriter::write_step() {
+    const int64_t table_size = header_.table_size;
+    const int64_t table_blocks = header_.table_blocks();
+    for (int64_t block = 0; block < table_blocks; block++) {
+        const int64_t begin = block * header_.block_entries;
+        const int64_t end = std::min<int64_t>(begin + header_.block_entries, table_size);
+        if (header_.steps > 0
+            && std::memcmp(&pending_[begin], &previous_[begin], (end - begin) * sizeof(action_type)) == 0) {
+            // same block as the previous step, which already points to a stored copy
+            directory_.push_back(directory_[directory_.size() - table_blocks]);
+            continue;
+        }
+        if (header_.block_count == std::numeric_limits<uint32_t>::max()) {
+            throw std::runtime_error("Time policy " + path_ + " has too many blocks");
+        }
+        std::fill(words_.begin(), words_.end(), 0);
+        for (int64_t position = begin; position < end; position++) {
+            const int64_t entry = position - begin;
+            words_[entry / TimePolicyHeader::ACTIONS_PER_WORD] |= static_cast<uint64_t>(pending_[position])
+                << (TimePolicyHeader::ACTION_BITS * (entry % TimePolicyHeader::ACTIONS_PER_WORD));
+        }
+        out_.write(reinterpret_cast<const char*>(words_.data()), words_.size() * sizeof(uint64_t));
+        directory_.push_back(header_.block_count++);
+    }
+    if (!out_) {
+        throw file_error("Cannot write", temporary_path_);
+    }
+    header_.steps++;
+}
+
+void TimePolicyWriter::finish() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closing_ = true;
+    }
+    changed_.notify_all();
+    thread_.join();
+    if (!error_.empty() || header_.steps == 0) {
+        out_.close();
+        std::remove(temporary_path_.c_str());
+        throw std::runtime_error(error_.empty() ? "Time policy " + path_ + " has no time step" : error_);
+    }
+
+    header_.directory_offset = header_.blocks_offset
+                             + uint64_t(header_.block_count) * header_.block_words() * sizeof(uint64_t);
+    out_.write(reinterpret_cast<const char*>(directory_.data()), directory_.size() * sizeof(uint32_t));
+    out_.seekp(0);
+    out_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+    out_.close();
+    if (!out_) {
+        std::remove(temporary_path_.c_str());
+        throw file_error("Cannot write", temporary_path_);
+    }
+    if (std::rename(temporary_path_.c_str(), path_.c_str()) != 0) {
+        std::remove(temporary_path_.c_str());
+        throw file_error("Cannot rename to", path_);
+    }
+}
+
+MappedTimePolicy MappedTimePolicy::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw file_error("Cannot open", path);
+    }
+    struct stat status;
+    if (::fstat(fd, &status) != 0) {
+        ::close(fd);
+        throw file_error("Cannot stat", path);
+    }
+    const size_t length = static_cast<size_t>(status.st_size);
+    if (length < sizeof(TimePolicyHeader)) {
+        ::close(fd);
+        throw std::runtime_error("Not a time policy file: " + path);
+    }
+    void* data = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        throw file_error("Cannot map", path);
+    }
+
+    MappedTimePolicy policy;
+    policy.data_ = data;
+    policy.length_ = length;
+
+    const TimePolicyHeader& header = policy.header();
+    const TimePolicyHeader expected;
+    if (std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0) {
+        throw std::runtime_error("Not a time policy file: " + path);
+    }
+    if (header.byte_order != TimePolicyHeader::BYTE_ORDER_MARK) {
+        throw std::runtime_error("Time policy file written with another byte order: " + path);
+    }
+    if (header.version != TimePolicyHeader::VERSION) {
+        throw std::runtime_error("Unsupported time policy file version " + std::to_string(header.version)
+                                 + " (expected " + std::to_string(TimePolicyHeader::VERSION) + "): " + path);
+    }
+    const uint64_t blocks_end = header.blocks_offset
+                              + uint64_t(header.block_count) * header.block_words() * sizeof(uint64_t);
+    const uint64_t directory_end = header.directory_offset
+                                 + uint64_t(header.steps) * header.table_blocks() * sizeof(uint32_t);
+    if (header.block_entries == 0 || header.steps <= 0 || header.blocks_offset < sizeof(TimePolicyHeader)
+        || header.blocks_offset % sizeof(uint64_t) != 0 || header.directory_offset < blocks_end
+        || directory_end > length) {
+        throw std::runtime_error("Truncated or corrupted time policy file: " + path);
+    }
+    const uint32_t* directory = policy.directory();
+    if (std::any_of(directory, directory + header.steps * header.table_blocks(),
+                    [&](uint32_t block) { return block >= header.block_count; })) {
+        throw std::runtime_error("Corrupted time policy directory: " + path);
+    }
+    return policy;
+}
+
+MappedTimePolicy::~MappedTimePolicy() {
+    unmap();
+}
+
+MappedTimePolicy::MappedTimePolicy(MappedTimePolicy&& other) noexcept
+    : data_(other.data_), length_(other.length_) {
+    other.data_ = nullptr;
+    other.length_ = 0;
+}
+
+MappedTimePolicy& MappedTimePolicy::operator=(MappedTimePolicy&& other) noexcept {
+    if (this != &other) {
+        unmap();
+        data_ = other.data_;
+        length_ = other.length_;
+        other.data_ = nullptr;
+        other.length_ = 0;
+    }
+    return *this;
+}
+
+void MappedTimePolicy::unmap() {
+    if (data_ != nullptr) {
+        ::munmap(data_, length_);
+        data_ = nullptr;
+        length_ = 0;
+    }
+}
@@ -0,0 +1,97 @@
+#include "transition_matrix.hpp"
+#include "utils.hpp"
+#include "successor_kernel.hpp"
+
+#include <limits>
+#include <stdexcept>
+
+namespace BOARD_NAMESPACE {
+
+namespace {
+
+// Hashes are enumerated in chunks, large enough to amortise the pool overhead
+constexpr int64_t BUILD_CHUNK_SIZE = 4096;
+
+/*
+ * Writes the successor positions of (current board of kernel, a) to out if out is not null.
+ * @returns the number of successors, 0 for an invalid move
+ */
+template <typename Index>
+int enumerate_successors(const SuccessorKernel& kernel, const Index& index, action_type a,
+                         transition_index_type* out) {
+    int64_t successors[SuccessorKernel::MAX_SUCCESSORS];
+    // same order as the Bellman sweep: 2=2^1 tile then 4=2^2 tile on each empty tile
+    const int length = kernel.successors(a, successors);
+    if (out != nullptr) {
+        for (int k = 0; k < length; k++) {
+            out[k] = static_cast<transition_index_type>(index.position(successors[k]));
+        }
+    }
+    return length;
+}
+
+}  // namespace
+
+template <typename Index>
+TransitionMatrix TransitionMatrix::build(int winning_objective, const Index& index, util::ThreadPool& pool) {
+    const int64_t table_size = index.size();
+    if (table_size - 1 > static_cast<int64_t>(std::numeric_limits<transition_index_type>::max())) {
+        throw std::length_error("State space too large for transition_index_type");
+    }
+
+    TransitionMatrix matrix;
+    matrix.action_lengths_.assign(table_size * PLAYER_ACTIONS, 0);
+    matrix.state_offsets_.assign(table_size + 1, 0);
+
+    // 1 - count successors of every (state, action)
+    // position 0 is the empty board: no valid player moves, its blocks stay empty
+    pool.parallel_for(1, table_size, BUILD_CHUNK_SIZE,
+        [&](int64_t chunk_begin, int64_t chunk_end) {
+            SuccessorKernel kernel(winning_objective);
+            for (int64_t position = chunk_begin; position < chunk_end; position++) {
+                kernel.seek(index.hash_at(position));
+                for (int a = 0; a < PLAYER_ACTIONS; a++) {
+                    matrix.action_lengths_[position * PLAYER_ACTIONS + a] = static_cast<uint8_t>(
+                        enumerate_successors(kernel, index, Actions::All[a], nullptr));
+                }
+            }
+        });
+
+    // 2 - prefix sum into per-state offsets
+    for (int64_t position = 0; position < table_size; position++) {
+        uint64_t state_length = 0;
+        for (int a = 0; a < PLAYER_ACTIONS; a++) {
+            state_length += matrix.action_lengths_[position * PLAYER_ACTIONS + a];
+        }
+        matrix.state_offsets_[position + 1] = matrix.state_offsets_[position] + state_length;
+    }
+    matrix.successors_.resize(matrix.state_offsets_[table_size]);
+
+    // 3 - fill successor positions, every state writes its own disjoint range
+    pool.parallel_for(1, table_size, BUILD_CHUNK_SIZE,
+        [&](int64_t chunk_begin, int64_t chunk_end) {
+            SuccessorKernel kernel(winning_objective);
+            for (int64_t position = chunk_begin; position < chunk_end; position++) {
+                kernel.seek(index.hash_at(position));
+                transition_index_type* out = matrix.successors_.data() + matrix.state_offsets_[position];
+                for (int a = 0; a < PLAYER_ACTIONS; a++) {
+                    out += enumerate_successors(kernel, index, Actions::All[a], out);
+                }
+            }
+        });
+
+    return matrix;
+}
+
+template TransitionMatrix TransitionMatrix::build(int, const DenseIndex&, util::ThreadPool&);
+template TransitionMatrix TransitionMatrix::build(int, const ReachableIndex&, util::ThreadPool&);
+template TransitionMatrix TransitionMatrix::build(int, const SparseIndex&, util::ThreadPool&);
+template TransitionMatrix TransitionMatrix::build(int, const SymmetricIndex&, util::ThreadPool&);
+
+size_t TransitionMatrix::memory_bytes() const {
+    return state_offsets_.size() * sizeof(uint64_t)
+         + action_lengths_.size() * sizeof(uint8_t)
+         + successors_.size() * sizeof(transition_index_type);
+}
+
+}  // namespace BOARD_NAMESPACE
@@ -4,9 +4,25 @@
 #include "state.hpp"
 #include "debug.hpp"
 #include "interrupt_handler.hpp"
+#include "thread_pool.hpp"
+#include "transition_matrix.hpp"
+#include "successor_kernel.hpp"
+#include "process_group.hpp"
+#include "time_policy.hpp"
+#include "solver_metrics.hpp"
 
 #include <iostream>
 #include <iomanip>
+#include <memory>
+#include <cmath>
+#include <chrono>
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace BOARD_NAMESPACE {
 
 /*
  * new policy at fixed time
@@ -48,6 +64,33 @@ reward_type r([[maybe_unused]] int t, [[maybe_unused]] State s, [[maybe_unused]]
     return 0;
 }
 
+int default_time_horizon(int winning_objective) {
+    int rows = State::ROWS;
+    int cols = State::COLS;
+
+    // if, on the turn T-1:
+    // - half of the grid + 1 is filled with winning_objective - 1
+    // - the other half was first filled with winning_objective - 2
+    // then game is winnable in no more than T turns
+    // in the worst case, this happens with only Nature moves of 2^1,
+    // so T = grid total / 2 + 1 suffices
+    int halfgrid = rows*cols /2;
+    int worse_case_total = pow(2,winning_objective-1)*(halfgrid + 1) + pow(2,winning_objective-2)* (rows*cols - halfgrid - 1);
+    return ( worse_case_total )/2 + 1;
+}
+
+int64_t state_space_size(int winning_objective) {
+    int64_t total_combinations = 1;
+    for (int i = 0; i < State::SIZE; i++) {
+        if (__builtin_mul_overflow(total_combinations, int64_t(winning_objective + 1), &total_combinations)) {
+            throw std::overflow_error("Objective " + std::to_string(winning_objective) + " on a "
+                                      + std::to_string(State::ROWS) + "x" + std::to_string(State::COLS)
+                                      + " board has more than 2^63 hashes");
+        }
+    }
+    return total_combinations;
+}
+
 // Legacy debug printing functions
 // TODO: remove with better logging system
 void print_gamestate(const State& gamestate) {
@@ -59,147 +102,616 @@ void print_move(action_type a) {
 }
 
 
-void optimal_policy(std::vector<action_type> &policy, std::vector<reward_type> &value, std::vector<reward_type> &new_value, int winning_objective, int T) {
-    int rows = State::ROWS;
-    int cols = State::COLS;
-    int total_combinations = pow((winning_objective+1), rows*cols);
-    PRINT(total_combinations);
+/*
+ * Bellman backup of a single state at a given time:
+ * writes new_value[position] and policy[position] from value (time+1),
+ * where position is the table entry of hashed_state in index.
+ * Only reads value, and only writes the entries of position,
+ * so any number of states can be backed up concurrently.
+ * Successors come from the hash kernel of the calling thread (see successor_kernel.hpp).
+ * Adds the valid moves and successors it evaluates to counters.
+ */
+template <typename Index, typename Storage>
+static void bellman_backup(int64_t position,
+                           const Index &index,
+                           [[maybe_unused]] int time,
+                           [[maybe_unused]] int T,
+                           SuccessorKernel &kernel,
+                           action_type* policy,
+                           const Storage* value,
+                           Storage* new_value,
+                           SweepCounters &counters) {
+    const int64_t hashed_state = index.hash_at(position);
+    // Note: the sweep visits increasing hashes, mostly consecutive ones for the dense index
+    const State& temp = kernel.seek(hashed_state);
+    if (time <= T-5) {PRINT_GAMESTATE(temp);}
+
+    //default
+    policy[position] = Action::None;
+                
+    reward_type max_bellman_expression = -1; //initialise max to -1
+    action_type argmax = Action::None;
+
+    int64_t successors[SuccessorKernel::MAX_SUCCESSORS];
+
+    //find max_bellman_expression and argmax over all actions (action_set)
+    for (auto a : Actions::All)
+    {
+        //Bellman expression: r + average value with action a
+        reward_type bellman_expression = r(time,temp,action_type(a));
+
+        if (a==Action::None) {
+            // None skips the turn
+            // so bellman_expression is previous value of the same state
+            bellman_expression = decode_value(value[position]);
+        } else {
+            // all Nature moves after the player move, a 2=2^1 then a 4=2^2 tile on each empty tile
+            const int length = kernel.successors(action_type(a), successors);
+
+            if (length > 0) {
+                counters.valid_moves++;
+                counters.successors += length;
+                if (time <= T-5) {PRINT(action_type(a));}
+                if (time <= T-5) {PRINT(length);}
+                // transition_probability is actually just :
+                // 1 - look at player move
+                // 2 - look at nature move
+                const reward_type probability = 1.0 / length;
+                for (int k = 0; k < length; k++)
+                {
+                    bellman_expression += decode_value(value[index.position(successors[k])]) * probability;
+                    if (time <= T-5) {PRINT(decode_value(value[index.position(successors[k])]));}
+                }
+            } else {
+                // ignore this move with sentinel penalty value
+                bellman_expression = -1;
+            }
+        }
+
+        if (bellman_expression > max_bellman_expression ) {
+            argmax = action_type(a);
+            max_bellman_expression = bellman_expression;
+        }
+    }
+    // std::cout << std::endl;
+    
+    // max_bellman_expression is done, update value and policy
+    // Note: the only rounding of a backup, sums above are accumulated in reward_type
+    new_value[position] = encode_value<Storage>(max_bellman_expression);
+    policy[position] = argmax;
+
+    if (time <= T-5) {
+        PRINT(max_bellman_expression);
+        PRINT(hashed_state);
+        PRINT_MOVE(argmax);
+        PRINT_GAMESTATE(temp);
+        #ifdef DEBUG
+        // pause after each state for debugging
+        std::cout << "Press Enter to continue..." << std::endl;
+        std::cin.get();
+        #endif
+    }
+}
+
+/*
+ * Same backup as bellman_backup, reading successor positions from the precomputed matrix
+ * instead of replaying the moves. r() is always 0 and is left out.
+ * Sums are accumulated in the same order, so values are bit-identical.
+ */
+template <typename Storage>
+static void bellman_backup_sparse(int64_t position,
+                                  const TransitionMatrix &transitions,
+                                  action_type* policy,
+                                  const Storage* value,
+                                  Storage* new_value,
+                                  SweepCounters &counters) {
+    const transition_index_type* successors = transitions.successors(position);
+
+    reward_type max_bellman_expression = -1; //initialise max to -1
+    action_type argmax = Action::None;
+
+    for (int a = 0; a < TransitionMatrix::PLAYER_ACTIONS; a++) {
+        int length = transitions.block_length(position, a);
+        // ignore invalid moves with sentinel penalty value
+        reward_type bellman_expression = -1;
+        if (length > 0) {
+            counters.valid_moves++;
+            counters.successors += length;
+            bellman_expression = 0;
+            const reward_type probability = 1.0 / length;
+            for (int k = 0; k < length; k++) {
+                bellman_expression += decode_value(value[successors[k]]) * probability;
+            }
+        }
+        successors += length;
+
+        if (bellman_expression > max_bellman_expression) {
+            argmax = Actions::All[a];
+            max_bellman_expression = bellman_expression;
+        }
+    }
+
+    // None skips the turn, it is evaluated last so that it only wins strictly
+    const reward_type previous_value = decode_value(value[position]);
+    if (previous_value > max_bellman_expression) {
+        argmax = Action::None;
+        max_bellman_expression = previous_value;
+    }
+
+    new_value[position] = encode_value<Storage>(max_bellman_expression);
+    policy[position] = argmax;
+}
+
+/*
+ * Value and policy tables of a sharded solve, in memory shared with the worker processes.
+ * Both are double-buffered: a step reads buffer b and writes buffer 1-b, so a worker
+ * that dies in the middle of a step leaves the tables of the previous one intact.
+ */
+template <typename Storage>
+struct SharedTables {
+    static_assert(std::is_trivially_copyable_v<Storage>, "tables are shared as raw bytes");
+
+    // what a worker did in its last step, read by the coordinator for the metrics
+    struct alignas(64) WorkerReport {
+        SweepCounters counters;
+        int64_t peak_rss_bytes;
+    };
+
+    SharedTables(int64_t size, int workers)
+        : size(size), reports_offset(aligned(2 * size * (sizeof(Storage) + sizeof(action_type)))),
+          memory(reports_offset + workers * sizeof(WorkerReport)) {}
+
+    Storage* value(int buffer) const { return static_cast<Storage*>(memory.data()) + buffer * size; }
+    action_type* policy(int buffer) const { return reinterpret_cast<action_type*>(value(2)) + buffer * size; }
+    WorkerReport& report(int worker) const {
+        return reinterpret_cast<WorkerReport*>(static_cast<char*>(memory.data()) + reports_offset)[worker];
+    }
+
+    static size_t aligned(size_t bytes) { return (bytes + alignof(WorkerReport) - 1) / alignof(WorkerReport) * alignof(WorkerReport); }
+
+    int64_t size;
+    size_t reports_offset;
+    util::SharedMemory memory;
+};
+
+// Argument of the first step of the worker processes, which copy their shard into the shared tables
+constexpr int64_t PLACE_SHARDS = -1;
+
+// States the vectorised backups are timed on before the first sweep, see fastest_simd_level
+constexpr int64_t SIMD_TRIAL_STATES = 1 << 15;
+
+/*
+ * Backwards induction over the states of index, shared by the dense and reachable solvers
+ */
+template <typename Index, typename Storage>
+static int backwards_induction(Table<action_type> &policy, Table<Storage> &value, Table<Storage> &new_value, int winning_objective, int T, const SolverOptions& options, const Index& index, util::ThreadPool& pool) {
+    const int64_t table_size = index.size();
+    PRINT(table_size);
+    if (options.processes > 1 && options.gauss_seidel) {
+        throw std::invalid_argument("Gauss-Seidel sweeps run in a single process");
+    }
 
     /* INITIALISE VALUE */
     // go through all possible positions for tiles
-    // TODO: adapt int size to total combinations
-    int64_t hashed_state = 0;
+    int64_t position = 0;
 
-    // allocated temporary game state
-    State temp;
+    // walks the boards of the table, see successor_kernel.hpp
+    SuccessorKernel kernel(winning_objective);
 
-    // initialising value to final time reward
-    while (hashed_state < total_combinations) {
-        hash_to_gamestate(winning_objective, hashed_state, temp);
-        value[hashed_state] = final_reward(winning_objective, temp);
+    // initialising value to final time reward, unless it holds the values of a previous solve
+    while (options.resume_steps == 0 && position < table_size) {
+        value[position] = encode_value<Storage>(final_reward(winning_objective, kernel.seek(index.hash_at(position))));
 
         // go to the next hash
-        hashed_state++;
+        position++;
+    }
+    if (options.resume_steps > 0) {
+        std::cout << "Resuming after " << options.resume_steps << " time steps" << std::endl;
     }
     
     //sum of rewards over all actions - average gain
     // reward_type* value_at_previous_time = final_time_reward(state_size); //initialise to final gain
 
+    TransitionMatrix transitions;
+    if (options.precompute_transitions) {
+        auto build_start = std::chrono::steady_clock::now();
+        transitions = TransitionMatrix::build(winning_objective, index, pool);
+        std::chrono::duration<double> build_time = std::chrono::steady_clock::now() - build_start;
+        std::cout << "Transition matrix: " << transitions.total_successors() << " successors, "
+                  << transitions.memory_bytes() / (1024.0 * 1024.0) << " MiB, built in "
+                  << build_time.count() << "s" << std::endl;
+    }
 
+    // Gauss-Seidel: backups write straight into value, and later states of the
+    // same sweep already see the new values of earlier ones
+    const bool in_place = options.gauss_seidel;
+    const bool sharded = options.processes > 1;
+
+    // precomputed backups of double values run in batches of states, one per SIMD lane
+    // Note: in place, later states of a batch would not see the new values of earlier ones
+    const bool vectorised = options.precompute_transitions && !in_place && std::is_same_v<Storage, double>;
+    SimdLevel simd = SimdLevel::Scalar;
+    if (vectorised && options.simd == SimdLevel::Auto) {
+        // Note: new_value is rewritten by every sweep and the trial actions go to a scratch table,
+        // so the trial backups leave no trace: policy may hold a resumed solve, saved if interrupted
+        // (sharded, new_value may be empty, a scratch table takes its place)
+        const int64_t trial_end = std::min<int64_t>(table_size, 1 + SIMD_TRIAL_STATES);
+        std::vector<Storage> scratch(sharded ? trial_end : 0);
+        std::vector<action_type> scratch_policy(trial_end);
+        if constexpr (std::is_same_v<Storage, double>) {
+            simd = fastest_simd_level(transitions.blocks(), 1, trial_end, value.data(),
+                                      sharded ? scratch.data() : new_value.data(), scratch_policy.data());
+        }
+        std::cout << "Vectorised backups= " << to_string(simd) << " (fastest on " << trial_end - 1 << " states)" << std::endl;
+    } else if (vectorised) {
+        simd = resolve_simd_level(options.simd);
+        std::cout << "Vectorised backups= " << to_string(simd) << std::endl;
+    }
+    const bool track_changes = options.tolerance >= 0;
+
+    // Backs up the states [begin, end) of time from read into write and write_policy,
+    // returns the largest change of value when tracked and adds the work done to counters
+    // Note: read_policy holds the actions of the previous time step, it may be write_policy itself
+    auto backup_range = [&](int time, const Storage* read, Storage* write, const action_type* read_policy,
+                            action_type* write_policy, int64_t begin, int64_t end, SweepCounters& counters) {
+        reward_type range_max_change = 0;
+        counters.states += end - begin;
+        if (vectorised) {
+            // runs of states small enough to keep their previous actions on the stack
+            constexpr int64_t RUN_STATES = 512;
+            action_type previous_policy[RUN_STATES];
+            for (int64_t run_begin = begin; run_begin < end; run_begin += RUN_STATES) {
+                const int64_t run_end = std::min(run_begin + RUN_STATES, end);
+                std::copy(read_policy + run_begin, read_policy + run_end, previous_policy);
+                if constexpr (std::is_same_v<Storage, double>) {
+                    simd_bellman_backup(simd, transitions.blocks(), run_begin, run_end, read, write, write_policy);
+                }
+                for (int64_t position = run_begin; position < run_end; position++) {
+                    counters.policy_changes += write_policy[position] != previous_policy[position - run_begin];
+                }
+            }
+            const uint8_t* lengths = transitions.blocks().action_lengths;
+            for (int64_t entry = begin * TransitionBlocks::PLAYER_ACTIONS; entry < end * TransitionBlocks::PLAYER_ACTIONS; entry++) {
+                counters.valid_moves += lengths[entry] > 0;
+                counters.successors += lengths[entry];
+            }
+            // Note: read is not written by the backups, it still holds the previous values
+            for (int64_t position = begin; track_changes && position < end; position++) {
+                range_max_change = std::max(range_max_change,
+                                            std::abs(decode_value(write[position]) - decode_value(read[position])));
+            }
+        }
+        SuccessorKernel range_kernel(winning_objective);
+        for (int64_t position = begin; !vectorised && position < end; position++) {
+            reward_type previous = decode_value(read[position]);
+            const action_type previous_action = read_policy[position];
+            if (options.precompute_transitions) {
+                bellman_backup_sparse(position, transitions, write_policy, read, write, counters);
+            } else {
+                bellman_backup(position, index, time, T, range_kernel, write_policy, read, write, counters);
+            }
+            counters.policy_changes += write_policy[position] != previous_action;
+            if (track_changes) {
+                range_max_change = std::max(range_max_change, std::abs(decode_value(write[position]) - previous));
+            }
+        }
+        return range_max_change;
+    };
+
+    // Sweep of [begin, end) in chunks on the threads of sweep_pool, counting backed up states in progress
+    // Note: each backup only reads read and writes its own entry of write and write_policy,
+    // so chunks can be computed in any order and the result is identical to a serial sweep.
+    // Counters are local to each chunk and added to counters once per chunk.
+    auto sweep = [&](util::ThreadPool& sweep_pool, int time, const Storage* read, Storage* write,
+                     const action_type* read_policy, action_type* write_policy, int64_t begin, int64_t end,
+                     std::atomic<int64_t>* progress, SweepCounters& counters) {
+        reward_type sweep_max_change = 0;
+        std::mutex chunk_mutex;
+        sweep_pool.parallel_for(begin, end, options.chunk_size, [&](int64_t chunk_begin, int64_t chunk_end) {
+            SweepCounters chunk_counters;
+            reward_type chunk_max_change = backup_range(time, read, write, read_policy, write_policy,
+                                                        chunk_begin, chunk_end, chunk_counters);
+            if (progress != nullptr) {
+                progress->fetch_add(chunk_end - chunk_begin, std::memory_order_relaxed);
+            }
+            std::lock_guard<std::mutex> lock(chunk_mutex);
+            counters += chunk_counters;
+            sweep_max_change = std::max(sweep_max_change, chunk_max_change);
+        });
+        return sweep_max_change;
+    };
+
+    // Sharded sweeps: worker processes each back up a contiguous shard of [1, table_size),
+    // on tables in shared memory (see SharedTables), and the coordinator waits for all of them
+    // at the end of each time step
+    std::unique_ptr<SharedTables<Storage>> shared;
+    std::unique_ptr<util::ProcessGroup> workers;
+    // buffer of the shared tables holding the last completed time step
+    int current = 0;
+    std::unique_ptr<util::ThreadPool> shard_pool;
+    // Note: while sharded, value and policy are only written by gather_tables
+    auto release_private_tables = [&]() {
+        util::release_table_pages(value.data(), value.size() * sizeof(Storage));
+        util::release_table_pages(policy.data(), policy.size() * sizeof(action_type));
+    };
+    auto shard_step = [&](int worker, int64_t time, std::atomic<int64_t>& progress) -> double {
+        // Note: threads do not survive fork, each worker starts its own pool on its first step
+        if (!shard_pool) {
+            shard_pool = std::make_unique<util::ThreadPool>(pool.size());
+        }
+        const int64_t begin = 1 + (table_size - 1) * worker / options.processes;
+        const int64_t end = 1 + (table_size - 1) * (worker + 1) / options.processes;
+        if (time == PLACE_SHARDS) {
+            // Note: value and policy are the copies of the coordinator's tables made by fork,
+            // the pages of each shard are first touched by the worker that sweeps it
+            shard_pool->parallel_for(begin, end, options.chunk_size, [&](int64_t chunk_begin, int64_t chunk_end) {
+                std::copy(value.begin() + chunk_begin, value.begin() + chunk_end, shared->value(0) + chunk_begin);
+                std::copy(policy.begin() + chunk_begin, policy.begin() + chunk_end, shared->policy(0) + chunk_begin);
+                std::fill(shared->value(1) + chunk_begin, shared->value(1) + chunk_end, Storage());
+                std::fill(shared->policy(1) + chunk_begin, shared->policy(1) + chunk_end, Action::None);
+            });
+            // the pages of the copies are freed once the coordinator and every worker dropped them
+            release_private_tables();
+            return 0;
+        }
+        // the coordinator alternates buffers once per time step, see current
+        const int read = (T - 1 - options.resume_steps - static_cast<int>(time)) % 2;
+        SweepCounters counters;
+        const double max_change = sweep(*shard_pool, static_cast<int>(time), shared->value(read),
+                                        shared->value(1 - read), shared->policy(read), shared->policy(1 - read),
+                                        begin, end, &progress, counters);
+        shared->report(worker) = {counters, peak_rss_bytes()};
+        return max_change;
+    };
+    if (sharded) {
+        shared = std::make_unique<SharedTables<Storage>>(table_size, options.processes);
+        shared->value(0)[0] = value[0];
+        shared->policy(0)[0] = policy[0];
+        workers = std::make_unique<util::ProcessGroup>(options.processes, shard_step);
+        std::cout << "Processes= " << workers->size() << ", shards of " << (table_size - 1) / options.processes
+                  << " states" << std::endl;
+        for (int worker = 0; worker < workers->size(); worker++) {
+            std::cout << "Worker " << worker << "= " << util::to_string(workers->placement()[worker]) << std::endl;
+        }
+        try {
+            workers->run(PLACE_SHARDS);
+        } catch (const util::WorkerFailure& e) {
+            throw std::runtime_error(std::string("Sharded solve could not start: ") + e.what());
+        }
+        release_private_tables();
+        std::cout << "Shared tables= " << util::to_string(util::table_placement(shared->memory.data(), shared->memory.size()))
+                  << std::endl;
+    }
+    // copies the last completed time step of the shared tables back to value and policy
+    auto gather_tables = [&]() {
+        std::copy(shared->value(current), shared->value(current) + table_size, value.begin());
+        std::copy(shared->policy(current), shared->policy(current) + table_size, policy.begin());
+    };
+
+    // the checkpoint holds the values and policy of the last completed time step
+    auto last_checkpoint = std::chrono::steady_clock::now();
+    auto write_checkpoint = [&](int steps_done) {
+        SolutionHeader header = options.checkpoint.header;
+        header.horizon = steps_done;
+        auto write_start = std::chrono::steady_clock::now();
+        if (sharded) {
+            gather_tables();
+        }
+        try {
+            save_solution(options.checkpoint.path, header, policy, value);
+            std::chrono::duration<double> write_time = std::chrono::steady_clock::now() - write_start;
+            std::cout << "Checkpoint of " << steps_done << " time steps written to "
+                      << options.checkpoint.path << " in " << write_time.count() << "s" << std::endl;
+        } catch (const std::runtime_error& e) {
+            std::cerr << "Checkpoint failed: " << e.what() << std::endl;
+        }
+        if (sharded) {
+            release_private_tables();
+        }
+        last_checkpoint = std::chrono::steady_clock::now();
+    };
+
+    // the policy of every time step, written while the next one is swept
+    std::unique_ptr<TimePolicyWriter> time_policy;
+    if (!options.time_policy_path.empty()) {
+        time_policy = std::make_unique<TimePolicyWriter>(options.time_policy_path, table_size, T-1-options.resume_steps,
+                                                         policy.get_allocator().options());
+    }
+    // Note: like a failed checkpoint, a failed time policy does not stop the solve
+    auto time_policy_failed = [&](const std::runtime_error& e) {
+        std::cerr << "Time policy failed: " << e.what() << std::endl;
+        time_policy.reset();
+    };
+
+    // one line of telemetry per time step
+    std::unique_ptr<MetricsWriter> metrics;
+    if (!options.metrics_path.empty()) {
+        metrics = std::make_unique<MetricsWriter>(options.metrics_path);
+    }
+    SweepCounters solve_counters;
+    double sweep_seconds = 0;
 
-    for (int time = T-1; time >= 0 ; time--)
+    int iterations = 0;
+    bool interrupted = false;
+    reward_type max_change = 0;
+    for (int time = T-1-options.resume_steps; time >= 0 ; time--)
     {
         if (util::global_stop_requested.load()) {
             std::cout << "\n[User Interrupt] MDP backwards induction stopped at time " << time+1 << std::endl;
+            if (!options.checkpoint.path.empty()) {
+                write_checkpoint(options.resume_steps + iterations);
+                std::cout << "Continue with --resume " << options.checkpoint.path << std::endl;
+            }
             util::global_stop_requested.store(false);
+            interrupted = true;
             break;
         }
 
         std::cout << "Time: " << time << std::endl;
+        const auto step_start = std::chrono::steady_clock::now();
+        StepMetrics step;
+        step.time = time;
 
         // policy will be rewritten
-        
-        State temp;
-
-        // hashed_state 0 is an empty board. It does not have any valid moves for player therefore game ends
-        policy[0] = Action::None;
-        new_value[0] = 0;
-
 
         // go through all possible positions for tiles, except 0 because you get Up as optimal move
-        for (int64_t hashed_state = 1; hashed_state < total_combinations; hashed_state++) {
-            // generate the gamestate, with only the decided empty tiles, all others empty
-            hash_to_gamestate(winning_objective, hashed_state, temp);
-            if (time <= T-5) {PRINT_GAMESTATE(temp);}
-
-            //default
-            policy[hashed_state] = Action::None;
-                        
-            reward_type max_bellman_expression = -1; //initialise max to -1
-            action_type argmax = Action::None;
-
-            //find max_bellman_expression and argmax over all actions (action_set)
-            for (auto a : Actions::All)
-            {
-                //Bellman expression: r + average value with action a
-                reward_type bellman_expression = r(time,temp,action_type(a));
-
-                if (a==Action::None) {
-                    // None skips the turn
-                    // so bellman_expression is previous value of the same state
-                    bellman_expression = value[hashed_state];
-                } else {
-                    // generate all Nature moves from Player move
-                    State temp_player_move(temp);
-                    
-                    // bool valid_move = player_move(temp_player_move,action_type(a));
-                    std::optional<State> next_state = State(temp_player_move).player_move(action_type(a));
-                    
-                    if (next_state.has_value()) {
-                        if (time <= T-5) {PRINT(action_type(a));}      
-                        if (time <= T-5) {PRINT_GAMESTATE(next_state.value());}
-                        // We must consider all Nature moves
-                        std::vector<Coord> nature = next_state.value().all_nature_moves();
-                        if (time <= T-5) {PRINT(nature.size());}
-                        for (std::size_t k = 0; k < nature.size(); k++)
-                        {
-                            if (time <= T-5) {PRINT(nature[k].i);}
-                            if (time <= T-5) {PRINT(nature[k].j);}
-
-                            State nature_move(next_state.value());
-                                                        
-                            // Nature generates a 2=2^1 tile
-                            // TODO: clean up this explicit access (by not using state_type directly)
-                            nature_move(nature[k].i, nature[k].j) = 1;
-                            int64_t hashed_state_prime_2 = gamestate_to_hash(winning_objective,nature_move);                            
-                            // if (time <= T-5) {PRINT_GAMESTATE(nature_move);}
-
-                            // Nature generates a 4=2^2 tile
-                            nature_move(nature[k].i, nature[k].j) = 2;
-                            int64_t hashed_state_prime_4 = gamestate_to_hash(winning_objective,nature_move);
-                            // if (time <= T-5) {PRINT_GAMESTATE(nature_move);}
-
-                            // transition_probability is actually just :
-                            // 1 - look at player move
-                            // 2 - look at nature move
-                            bellman_expression += value[hashed_state_prime_2] * 1.0/(nature.size()*2);
-                            bellman_expression += value[hashed_state_prime_4] * 1.0/(nature.size()*2);
-                            if (time <= T-5) {PRINT(value[hashed_state_prime_2]);}
-                            if (time <= T-5) {PRINT(value[hashed_state_prime_4]);}
-
-                        }
-                    } else {
-                        // ignore this move with sentinel penalty value
-                        bellman_expression = -1;
-                    }
+        // position 0 is an empty board. It does not have any valid moves for player therefore game ends
+        if (sharded) {
+            shared->policy(1 - current)[0] = Action::None;
+            shared->value(1 - current)[0] = encode_value<Storage>(0);
+            try {
+                auto report = [&](int64_t progress) {
+                    std::cout << "Time: " << time << ", " << std::fixed << std::setprecision(1)
+                              << 100.0 * progress / (table_size - 1) << "% of states" << std::defaultfloat << std::endl;
+                };
+                std::vector<double> changes = workers->run(time, report);
+                max_change = *std::max_element(changes.begin(), changes.end());
+                for (int worker = 0; worker < workers->size(); worker++) {
+                    step.counters += shared->report(worker).counters;
+                    step.worker_peak_rss_bytes = std::max(step.worker_peak_rss_bytes,
+                                                          shared->report(worker).peak_rss_bytes);
                 }
-
-                if (bellman_expression > max_bellman_expression ) {
-                    argmax = action_type(a);
-                    max_bellman_expression = bellman_expression;
+            } catch (const util::WorkerFailure& e) {
+                // Note: workers only write the buffers of the step in progress, the last completed one is intact
+                std::cerr << "\n[Worker failure] " << e.what() << ", MDP backwards induction stopped at time "
+                          << time+1 << std::endl;
+                if (!options.checkpoint.path.empty()) {
+                    write_checkpoint(options.resume_steps + iterations);
+                    std::cout << "Continue with --resume " << options.checkpoint.path << std::endl;
                 }
+                interrupted = true;
+                break;
             }
-            // std::cout << std::endl;
-            
-            // max_bellman_expression is done, update value and policy
-            new_value[hashed_state] = max_bellman_expression;
-            policy[hashed_state] = argmax;
-
-            if (time <= T-5) {
-                PRINT(max_bellman_expression);
-                PRINT(hashed_state);
-                PRINT_MOVE(argmax);
-                PRINT_GAMESTATE(temp);
-                #ifdef DEBUG
-                // pause after each state for debugging
-                std::cout << "Press Enter to continue..." << std::endl;
-                std::cin.get();
-                #endif
+            current = 1 - current;
+        } else if (in_place) {
+            policy[0] = Action::None;
+            value[0] = encode_value<Storage>(0);
+            // Note: in place, the result depends on the order of the sweep, which stays serial
+            max_change = backup_range(time, value.data(), value.data(), policy.data(), policy.data(), 1, table_size,
+                                      step.counters);
+        } else {
+            policy[0] = Action::None;
+            new_value[0] = encode_value<Storage>(0);
+            max_change = sweep(pool, time, value.data(), new_value.data(), policy.data(), policy.data(), 1, table_size,
+                               nullptr, step.counters);
+
+            // exchange pointers to value and new_value
+            value.swap(new_value);
+        }
+        iterations++;
+
+        std::chrono::duration<double> step_time = std::chrono::steady_clock::now() - step_start;
+        sweep_seconds += step_time.count();
+        solve_counters += step.counters;
+        if (metrics) {
+            step.step = iterations;
+            step.seconds = step_time.count();
+            step.max_change = track_changes ? max_change : -1;
+            step.peak_rss_bytes = peak_rss_bytes();
+            try {
+                metrics->write(step);
+            } catch (const std::runtime_error& e) {
+                // Note: like a failed checkpoint, failed metrics do not stop the solve
+                std::cerr << "Metrics failed: " << e.what() << std::endl;
+                metrics.reset();
             }
+        }
 
+        if (time_policy) {
+            try {
+                time_policy->add_step(sharded ? shared->policy(current) : policy.data());
+            } catch (const std::runtime_error& e) {
+                time_policy_failed(e);
+            }
+        }
+
+        if (track_changes && max_change <= options.tolerance) {
+            std::cout << "Converged at time " << time << ", max change= " << max_change
+                      << " <= tolerance= " << options.tolerance << std::endl;
+            break;
         }
 
-        // exchange pointers to value and new_value
-        value.swap(new_value);
+        std::chrono::duration<double> since_checkpoint = std::chrono::steady_clock::now() - last_checkpoint;
+        if (!options.checkpoint.path.empty() && time > 0
+            && since_checkpoint.count() >= options.checkpoint.interval_seconds) {
+            write_checkpoint(options.resume_steps + iterations);
+        }
+    }
+    if (sharded) {
+        gather_tables();
+    }
+    if (time_policy) {
+        try {
+            time_policy->finish();
+            const TimePolicyHeader& header = time_policy->header();
+            const int64_t table_blocks = header.steps * header.table_blocks();
+            std::cout << "Time policy= " << header.steps << " time steps, " << header.block_count << " of "
+                      << table_blocks << " blocks stored, "
+                      << (header.directory_offset + table_blocks * sizeof(uint32_t)) / (1024.0 * 1024.0)
+                      << " MiB written to " << options.time_policy_path << std::endl;
+        } catch (const std::runtime_error& e) {
+            time_policy_failed(e);
+        }
+    }
+
+    std::cout << "Iterations= " << iterations << " of " << T - options.resume_steps;
+    if (track_changes) {
+        std::cout << ", last max change= " << max_change;
+    }
+    std::cout << std::endl;
+    if (iterations > 0) {
+        std::cout << "Backups= " << solve_counters.states << " states, "
+                  << (sweep_seconds > 0 ? solve_counters.states / sweep_seconds : 0) << " states/s, "
+                  << solve_counters.successors << " successors, " << solve_counters.policy_changes
+                  << " policy changes, peak RSS= " << peak_rss_bytes() / (1024.0 * 1024.0) << " MiB" << std::endl;
+    }
+
+    // Note: converged values are those of every longer horizon
+    return interrupted ? options.resume_steps + iterations : T;
+}
+
+static int solver_threads(const SolverOptions& options) {
+    int threads = options.threads;
+    #ifdef DEBUG
+    // debug prints pause on every state, they only make sense in order
+    threads = 1;
+    #endif
+    return threads;
+}
+
+int optimal_policy(Table<action_type> &policy, Table<reward_type> &value, Table<reward_type> &new_value, int winning_objective, int T, const SolverOptions& options) {
+    const int64_t total_combinations = state_space_size(winning_objective);
+    PRINT(total_combinations);
+
+    // Note: the pool is created once, workers sleep between time steps
+    util::ThreadPool pool(solver_threads(options));
+    if (pool.size() > 1) {
+        std::cout << "Threads= " << pool.size() << std::endl;
     }
-}
\ No newline at end of file
+
+    return backwards_induction(policy, value, new_value, winning_objective, T, options, DenseIndex(total_combinations), pool);
+}
+
+template <typename Index, typename Storage>
+int optimal_policy(Table<action_type> &policy, Table<Storage> &value, Table<Storage> &new_value, int winning_objective, int T, const Index& index, const SolverOptions& options) {
+    util::ThreadPool pool(solver_threads(options));
+    if (pool.size() > 1) {
+        std::cout << "Threads= " << pool.size() << std::endl;
+    }
+
+    return backwards_induction(policy, value, new_value, winning_objective, T, options, index, pool);
+}
+
+// every state index with every value table entry
+#define INSTANTIATE_OPTIMAL_POLICY(Storage) \
+    template int optimal_policy(Table<action_type>&, Table<Storage>&, Table<Storage>&, int, int, const DenseIndex&, const SolverOptions&); \
+    template int optimal_policy(Table<action_type>&, Table<Storage>&, Table<Storage>&, int, int, const ReachableIndex&, const SolverOptions&); \
+    template int optimal_policy(Table<action_type>&, Table<Storage>&, Table<Storage>&, int, int, const SparseIndex&, const SolverOptions&); \
+    template int optimal_policy(Table<action_type>&, Table<Storage>&, Table<Storage>&, int, int, const SymmetricIndex&, const SolverOptions&);
+INSTANTIATE_OPTIMAL_POLICY(double)
+INSTANTIATE_OPTIMAL_POLICY(float)
+INSTANTIATE_OPTIMAL_POLICY(Fixed16)
+INSTANTIATE_OPTIMAL_POLICY(Quantized8)
+#undef INSTANTIATE_OPTIMAL_POLICY
+
+}  // namespace BOARD_NAMESPACE
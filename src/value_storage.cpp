@@ -0,0 +1,33 @@
+#include "value_storage.hpp"
+
+#include <stdexcept>
+
+std::string to_string(ValuePrecision precision) {
+    switch (precision) {
+    case ValuePrecision::Double:     return ValueStorage<double>::NAME;
+    case ValuePrecision::Float:      return ValueStorage<float>::NAME;
+    case ValuePrecision::Fixed16:    return ValueStorage<Fixed16>::NAME;
+    case ValuePrecision::Quantized8: return ValueStorage<Quantized8>::NAME;
+    }
+    return ValueStorage<double>::NAME;
+}
+
+ValuePrecision parse_value_precision(const std::string& name) {
+    for (ValuePrecision precision : {ValuePrecision::Double, ValuePrecision::Float,
+                                     ValuePrecision::Fixed16, ValuePrecision::Quantized8}) {
+        if (name == to_string(precision)) {
+            return precision;
+        }
+    }
+    throw std::invalid_argument("Unknown precision: " + name + " (double, float, fixed16 or quant8)");
+}
+
+size_t value_bytes(ValuePrecision precision) {
+    switch (precision) {
+    case ValuePrecision::Double:     return sizeof(double);
+    case ValuePrecision::Float:      return sizeof(float);
+    case ValuePrecision::Fixed16:    return sizeof(Fixed16);
+    case ValuePrecision::Quantized8: return sizeof(Quantized8);
+    }
+    return sizeof(double);
+}
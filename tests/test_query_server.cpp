@@ -0,0 +1,66 @@
+#include "query_server.hpp"
+#include "utils.hpp"
+
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace BOARD_NAMESPACE;
+
+TEST(QueryServerTest, PackedBoardHashMatchesGamestateHash) {
+    constexpr int kObjective = 5;
+    std::srand(7);
+    for (int trial = 0; trial < 1000; trial++) {
+        State gamestate;
+        uint64_t board = 0;
+        for (int i = 0; i < State::SIZE; i++) {
+            // includes tiles above the objective, which are clamped
+            const int tile = std::rand() % (kObjective + 3);
+            gamestate(i / State::COLS, i % State::COLS) = tile;
+            board |= static_cast<uint64_t>(tile) << (4 * i);
+        }
+        EXPECT_EQ(gamestate_to_hash(kObjective, gamestate), packed_board_hash(kObjective, board));
+    }
+}
+
+TEST(QueryServerTest, AnswersEveryBatchInOrder) {
+    int requests[2];
+    int responses[2];
+    ASSERT_EQ(0, ::pipe(requests));
+    ASSERT_EQ(0, ::pipe(responses));
+
+    // two batches, then the end of the session
+    const std::vector<uint64_t> first = {3, 1, 4};
+    const std::vector<uint64_t> second = {15};
+    const uint32_t end = 0;
+    for (const auto& batch : {first, second}) {
+        const uint32_t count = static_cast<uint32_t>(batch.size());
+        ASSERT_EQ(sizeof(count), static_cast<size_t>(::write(requests[1], &count, sizeof(count))));
+        const size_t bytes = batch.size() * sizeof(uint64_t);
+        ASSERT_EQ(bytes, static_cast<size_t>(::write(requests[1], batch.data(), bytes)));
+    }
+    ASSERT_EQ(sizeof(end), static_cast<size_t>(::write(requests[1], &end, sizeof(end))));
+
+    QueryLookup lookup = [](const uint64_t* boards, QueryAnswer* answers, uint32_t count) {
+        for (uint32_t k = 0; k < count; k++) {
+            answers[k] = QueryAnswer{static_cast<uint8_t>(boards[k] % 4), {}, boards[k] / 16.0f};
+        }
+    };
+    const QueryStatistics statistics = serve_queries(requests[0], responses[1], lookup);
+    EXPECT_EQ(2u, statistics.batches);
+    EXPECT_EQ(4u, statistics.queries);
+
+    std::vector<QueryAnswer> answers(4);
+    const size_t bytes = answers.size() * sizeof(QueryAnswer);
+    ASSERT_EQ(bytes, static_cast<size_t>(::read(responses[0], answers.data(), bytes)));
+    const std::vector<uint64_t> boards = {3, 1, 4, 15};
+    for (size_t k = 0; k < boards.size(); k++) {
+        EXPECT_EQ(boards[k] % 4, answers[k].action);
+        EXPECT_FLOAT_EQ(boards[k] / 16.0f, answers[k].value);
+    }
+    for (int fd : {requests[0], requests[1], responses[0], responses[1]}) {
+        ::close(fd);
+    }
+}
@@ -0,0 +1,88 @@
+#include "simulator.hpp"
+#include "utils.hpp"
+#include "state_index.hpp"
+#include "completion_solver.hpp"
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <map>
+#include <vector>
+
+using namespace BOARD_NAMESPACE;
+
+TEST(SimulatorTest, RandomNatureMoveIsUniformOverEmptyMoves) {
+    State gamestate;
+    gamestate(0, 0) = 1;
+    gamestate(State::ROWS - 1, State::COLS - 1) = 3;
+    const int moves = 2 * gamestate.count_empty_tiles();
+
+    util::Xoshiro256 generator(1);
+    constexpr int kDraws = 200000;
+    std::map<std::pair<int, int>, int> counts;
+    for (int k = 0; k < kDraws; k++) {
+        State next = gamestate.random_nature_move(generator).value();
+        for (int i = 0; i < State::SIZE; i++) {
+            int r = i / State::COLS;
+            int c = i % State::COLS;
+            if (next(r, c) != gamestate(r, c)) {
+                EXPECT_EQ(0, gamestate(r, c));
+                counts[{i, next(r, c)}]++;
+            }
+        }
+    }
+    ASSERT_EQ(static_cast<size_t>(moves), counts.size());
+    for (const auto& [move, count] : counts) {
+        EXPECT_NEAR(1.0 / moves, static_cast<double>(count) / kDraws, 0.1 / moves);
+    }
+
+    State full;
+    for (int i = 0; i < State::SIZE; i++) {
+        full(i / State::COLS, i % State::COLS) = 1;
+    }
+    EXPECT_FALSE(full.random_nature_move(generator).has_value());
+}
+
+TEST(SimulatorTest, WinRateMatchesSolvedValue) {
+    // 32 on 2x3 is won about 99% of the time
+    constexpr int kObjective = 5;
+    const int64_t total_combinations = std::llround(std::pow(kObjective + 1, State::SIZE));
+    if (total_combinations > 5e5) {
+        GTEST_SKIP() << "State space too large for a unit test.";
+    }
+    const DenseIndex dense(total_combinations);
+    Table<action_type> policy(dense.size());
+    Table<reward_type> value(dense.size());
+    optimal_policy_to_completion(policy, value, kObjective, dense);
+
+    reward_type start_value = 0;
+    for (int i = 0; i < State::SIZE; i++) {
+        for (int8_t power : {int8_t(1), int8_t(2)}) {
+            State first_board;
+            first_board(i / State::COLS, i % State::COLS) = power;
+            start_value += value[gamestate_to_hash(kObjective, first_board)] / (2.0 * State::SIZE);
+        }
+    }
+
+    PolicyFunction play = [&](const State& gamestate, int) {
+        return policy[gamestate_to_hash(kObjective, gamestate)];
+    };
+    SimulationOptions options;
+    options.games = 20000;
+    options.chunk_size = 1000;
+    const SimulationResult serial = simulate_games(kObjective, play, options);
+
+    // 4 standard deviations: the fixed seed makes the test deterministic, this only absorbs the seed choice
+    const double deviation = std::sqrt(start_value * (1 - start_value) / options.games);
+    EXPECT_NEAR(start_value, serial.win_rate(), 4 * deviation + 1e-9);
+    double low = 0;
+    double high = 0;
+    serial.confidence_interval(low, high);
+    EXPECT_LE(low, serial.win_rate());
+    EXPECT_GE(high, serial.win_rate());
+
+    // games only depend on the seed and the chunks
+    options.threads = 3;
+    const SimulationResult parallel = simulate_games(kObjective, play, options);
+    EXPECT_EQ(serial.wins, parallel.wins);
+    EXPECT_EQ(serial.player_moves, parallel.player_moves);
+}
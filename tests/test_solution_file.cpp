@@ -0,0 +1,148 @@
+#include "solution_file.hpp"
+#include "time_policy.hpp"
+#include "state.hpp"
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace BOARD_NAMESPACE;
+
+namespace {
+
+std::string temporary_path(const std::string& name) {
+    // Note: the tests of every board size may run at once
+    return testing::TempDir() + "solution_file_" + std::to_string(State::ROWS) + "x"
+           + std::to_string(State::COLS) + "_" + name;
+}
+
+SolutionHeader board_header() {
+    SolutionHeader header;
+    header.rows = State::ROWS;
+    header.cols = State::COLS;
+    header.winning_objective = 4;
+    header.horizon = 8;
+    return header;
+}
+
+}  // namespace
+
+TEST(SolutionFileTest, MappedTablesMatchSavedTables) {
+    const std::string path = temporary_path("round_trip");
+    // odd size so that the value table needs padding to be aligned
+    const Table<action_type> policy = {Action::None, Action::Up, Action::Left, Action::Right, Action::Down};
+    const Table<Fixed16> value = {{0}, {1}, {32768}, {65534}, {65535}};
+    save_solution(path, board_header(), policy, value);
+
+    const MappedSolution solution = MappedSolution::open(path);
+    EXPECT_EQ(4, solution.header().winning_objective);
+    EXPECT_EQ(8, solution.header().horizon);
+    EXPECT_EQ(ValuePrecision::Fixed16, solution.precision());
+    ASSERT_EQ(policy.size(), solution.header().table_size);
+    for (size_t k = 0; k < policy.size(); k++) {
+        EXPECT_EQ(policy[k], solution.policy()[k]);
+        EXPECT_EQ(value[k].raw, solution.values<Fixed16>()[k].raw);
+    }
+    EXPECT_THROW(solution.values<double>(), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+TEST(SolutionFileTest, RejectsOtherBoardsAndTruncatedFiles) {
+    const std::string path = temporary_path("invalid");
+    const Table<action_type> policy(100, Action::Up);
+    const Table<double> value(100, 0.5);
+
+    SolutionHeader other_board = board_header();
+    // no board of this many rows is built
+    other_board.rows = 9;
+    save_solution(path, other_board, policy, value);
+    EXPECT_THROW(MappedSolution::open(path), std::runtime_error);
+
+    save_solution(path, board_header(), policy, value);
+    EXPECT_NO_THROW(MappedSolution::open(path));
+    // drop the last value
+    std::ifstream in(path, std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    std::ofstream(path, std::ios::binary | std::ios::trunc).write(bytes.data(), bytes.size() - sizeof(double));
+    EXPECT_THROW(MappedSolution::open(path), std::runtime_error);
+
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << "not a solution";
+    EXPECT_THROW(MappedSolution::open(path), std::runtime_error);
+    EXPECT_THROW(MappedSolution::open(temporary_path("missing")), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+TEST(SolutionFileTest, RejectsCorruptedSizesAndActions) {
+    const std::string path = temporary_path("corrupted");
+    const Table<action_type> policy(100, Action::Up);
+    const Table<double> value(100, 0.5);
+    save_solution(path, board_header(), policy, value);
+    std::ifstream in(path, std::ios::binary);
+    const std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    SolutionHeader header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+
+    auto open_with = [&](const SolutionHeader& corrupted, size_t policy_entry, uint8_t action) {
+        std::string file = bytes;
+        std::memcpy(file.data(), &corrupted, sizeof(corrupted));
+        file[header.policy_offset + policy_entry] = static_cast<char>(action);
+        std::ofstream(path, std::ios::binary | std::ios::trunc).write(file.data(), file.size());
+        return MappedSolution::open(path);
+    };
+    EXPECT_NO_THROW(open_with(header, 0, static_cast<uint8_t>(Action::None)));
+    EXPECT_THROW(open_with(header, 99, static_cast<uint8_t>(Action::None) + 1), std::runtime_error);
+
+    // value_offset + table_size * 8 wraps around to a small offset inside the file
+    SolutionHeader wrapping = header;
+    wrapping.table_size = (uint64_t(1) << 61) + 1;
+    EXPECT_THROW(open_with(wrapping, 0, static_cast<uint8_t>(Action::Up)), std::runtime_error);
+    wrapping = header;
+    wrapping.policy_offset = ~uint64_t(0) - 50;
+    EXPECT_THROW(open_with(wrapping, 0, static_cast<uint8_t>(Action::Up)), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+TEST(TimePolicyFileTest, UnchangedBlocksAreStoredOnce) {
+    const std::string path = temporary_path("time_policy");
+    // two and a half blocks, the last one partly used
+    const int64_t table_size = 5 * TimePolicyWriter::BLOCK_ENTRIES / 2;
+    std::vector<action_type> steps[3];
+    for (int64_t position = 0; position < table_size; position++) {
+        steps[0].push_back(Actions::All[position % 5]);
+    }
+    // only the last block changes, then nothing
+    steps[1] = steps[0];
+    steps[1][table_size - 1] = steps[0][table_size - 1] == Action::Up ? Action::Down : Action::Up;
+    steps[2] = steps[1];
+    {
+        TimePolicyWriter writer(path, table_size, 10);
+        for (const auto& step : steps) {
+            writer.add_step(step.data());
+        }
+        writer.finish();
+        EXPECT_EQ(3 + 1, writer.header().block_count);
+    }
+
+    const MappedTimePolicy policy = MappedTimePolicy::open(path);
+    EXPECT_EQ(3, policy.header().steps);
+    for (int time = 8; time <= 10; time++) {
+        for (int64_t position = 0; position < table_size; position++) {
+            ASSERT_EQ(steps[10 - time][position], policy.action(time, position)) << time << " " << position;
+        }
+    }
+    // times outside of the solve use the nearest step
+    EXPECT_EQ(steps[0][table_size - 1], policy.action(11, table_size - 1));
+    EXPECT_EQ(steps[2][table_size - 1], policy.action(0, table_size - 1));
+
+    // a file cut short is rejected
+    std::ifstream in(path, std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::ofstream(path, std::ios::binary | std::ios::trunc).write(bytes.data(), bytes.size() - 4);
+    EXPECT_THROW(MappedTimePolicy::open(path), std::runtime_error);
+    std::remove(path.c_str());
+}
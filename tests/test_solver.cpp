@@ -0,0 +1,584 @@
+#include "state.hpp"
+#include "utils.hpp"
+#include "state_index.hpp"
+#include "thread_pool.hpp"
+#include "symmetry.hpp"
+#include "completion_solver.hpp"
+#include "value_storage.hpp"
+#include "solution_file.hpp"
+#include "process_group.hpp"
+#include "time_policy.hpp"
+#include "solver_metrics.hpp"
+#include "multi_objective.hpp"
+#include "expectimax.hpp"
+#include "prioritized_sweeping.hpp"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sched.h>
+#include <string>
+#include <vector>
+
+using namespace BOARD_NAMESPACE;
+
+namespace {
+
+// Small objective and horizon so every board size solves in a fraction of a second
+constexpr int kObjective = 4;
+constexpr int kHorizon = 8;
+
+// Skips tests whose dense state space has more than limit boards
+#define SKIP_IF_STATE_SPACE_LARGER_THAN(limit)                              \
+    do {                                                                    \
+        if (std::pow(kObjective + 1, State::SIZE) > (limit)) {              \
+            GTEST_SKIP() << "State space too large for a unit test.";       \
+        }                                                                   \
+    } while (0)
+
+#define SKIP_IF_STATE_SPACE_TOO_LARGE() SKIP_IF_STATE_SPACE_LARGER_THAN(2e6)
+
+struct Solution {
+    Table<action_type> policy;
+    Table<reward_type> value;
+};
+
+Solution solve(const SolverOptions& options, int objective = kObjective, int T = kHorizon) {
+    int64_t total_combinations = std::llround(std::pow(objective + 1, State::SIZE));
+    Solution solution;
+    solution.policy.resize(total_combinations);
+    solution.value.resize(total_combinations);
+    Table<reward_type> new_value(total_combinations);
+    optimal_policy(solution.policy, solution.value, new_value, objective, T, options);
+    return solution;
+}
+
+// Compares values bit for bit, not up to a tolerance
+void expect_identical(const Solution& expected, const Solution& actual) {
+    ASSERT_EQ(expected.value.size(), actual.value.size());
+    EXPECT_EQ(0, std::memcmp(expected.value.data(), actual.value.data(),
+                             expected.value.size() * sizeof(reward_type)));
+    EXPECT_EQ(expected.policy, actual.policy);
+}
+
+}  // namespace
+
+TEST(SolverTest, ParallelSweepIsBitIdenticalToSerial) {
+    SKIP_IF_STATE_SPACE_TOO_LARGE();
+
+    const Solution serial = solve(SolverOptions());
+
+    SolverOptions parallel;
+    parallel.threads = 4;
+    // tiny chunks so threads interleave as much as possible
+    parallel.chunk_size = 7;
+    expect_identical(serial, solve(parallel));
+}
+
+TEST(SolverTest, PrecomputedTransitionsAreBitIdenticalToSweep) {
+    SKIP_IF_STATE_SPACE_TOO_LARGE();
+
+    const Solution sweep = solve(SolverOptions());
+
+    SolverOptions sparse;
+    sparse.precompute_transitions = true;
+    expect_identical(sweep, solve(sparse));
+
+    sparse.threads = 3;
+    expect_identical(sweep, solve(sparse));
+}
+
+TEST(SolverTest, VectorisedBackupsAreBitIdenticalAtEveryLevel) {
+    SKIP_IF_STATE_SPACE_LARGER_THAN(1e5);
+
+    const Solution sweep = solve(SolverOptions());
+    for (SimdLevel level : {SimdLevel::Scalar, SimdLevel::SSE4, SimdLevel::AVX2, SimdLevel::AVX512}) {
+        if (!simd_supported(level)) continue;
+        SolverOptions vectorised;
+        vectorised.precompute_transitions = true;
+        vectorised.simd = level;
+        // chunks that do not split in full batches, the last states of each are backed up one at a time
+        vectorised.threads = 2;
+        vectorised.chunk_size = 13;
+        SCOPED_TRACE(to_string(level));
+        expect_identical(sweep, solve(vectorised));
+    }
+    EXPECT_THROW(parse_simd_level("neon"), std::invalid_argument);
+}
+
+TEST(SolverTest, ShardedSolveIsBitIdenticalToThreads) {
+    SKIP_IF_STATE_SPACE_LARGER_THAN(1e5);
+
+    const Solution sweep = solve(SolverOptions());
+    for (bool precompute : {false, true}) {
+        SolverOptions sharded;
+        sharded.processes = 3;
+        sharded.threads = 2;
+        sharded.chunk_size = 13;
+        sharded.precompute_transitions = precompute;
+        SCOPED_TRACE(precompute ? "precomputed" : "sweep");
+        expect_identical(sweep, solve(sharded));
+    }
+}
+
+TEST(ProcessGroupTest, WorkerCrashIsReportedAndStopsTheGroup) {
+    util::ProcessGroup group(3, [](int worker, int64_t argument, std::atomic<int64_t>& progress) {
+        if (argument == 2 && worker == 1) {
+            std::raise(SIGKILL);
+        }
+        progress += 1;
+        return double(worker * argument);
+    });
+    ASSERT_EQ(3, group.size());
+    EXPECT_EQ(std::vector<double>({0, 1, 2}), group.run(1));
+    EXPECT_EQ(std::vector<double>({0, 3, 6}), group.run(3));
+    EXPECT_THROW(group.run(2), util::WorkerFailure);
+    EXPECT_EQ(0, group.size());
+    EXPECT_THROW(group.run(1), util::WorkerFailure);
+}
+
+TEST(ProcessGroupTest, WorkersRunOnTheirPlacement) {
+    util::ProcessGroup group(3, [](int, int64_t, std::atomic<int64_t>&) { return double(sched_getcpu()); });
+    const std::vector<double> cpus = group.run(0);
+    ASSERT_EQ(3u, group.placement().size());
+    for (int worker = 0; worker < 3; worker++) {
+        SCOPED_TRACE(worker);
+        const std::vector<int>& placed = group.placement()[worker].cpus;
+        ASSERT_FALSE(placed.empty());
+        EXPECT_NE(placed.end(), std::find(placed.begin(), placed.end(), static_cast<int>(cpus[worker])));
+    }
+    EXPECT_EQ("CPUs 0-3,8,10-11 (node 1)", util::to_string(util::WorkerPlacement{1, {0, 1, 2, 3, 8, 10, 11}}));
+}
+
+TEST(TableAllocatorTest, LargeTablesAreZeroedAndReported) {
+    for (util::HugePages pages : {util::HugePages::Auto, util::HugePages::Off}) {
+        SCOPED_TRACE(util::to_string(pages));
+        // not a whole number of huge pages, the last one is partly used
+        const int64_t size = 3 * util::HUGE_PAGE_BYTES / sizeof(reward_type) + 5;
+        Table<reward_type> table(size, util::TableAllocator<reward_type>({pages, 3}));
+        EXPECT_TRUE(std::all_of(table.begin(), table.end(), [](reward_type entry) { return entry == 0; }));
+
+        const util::TablePlacement placement = util::table_placement(table.data(), size * sizeof(reward_type));
+        EXPECT_LE(placement.huge_bytes, placement.bytes);
+        if (pages == util::HugePages::Off) {
+            EXPECT_EQ(0u, placement.huge_bytes);
+        }
+        size_t placed = 0;
+        for (const auto& [node, bytes] : placement.node_bytes) {
+            placed += bytes;
+        }
+        EXPECT_LE(placed, placement.bytes);
+    }
+    EXPECT_THROW(util::parse_huge_pages("gigantic"), std::invalid_argument);
+}
+
+TEST(TableAllocatorTest, ReusedMemoryIsZeroed) {
+    // Note: entries are not constructed, both sizes must come back zeroed after a table was freed
+    for (const int64_t size : {int64_t(1000), int64_t(util::HUGE_PAGE_BYTES / sizeof(reward_type) + 5)}) {
+        SCOPED_TRACE(size);
+        for (int round = 0; round < 2; round++) {
+            Table<reward_type> table(size, util::TableAllocator<reward_type>({util::HugePages::Auto, 2}));
+            EXPECT_TRUE(std::all_of(table.begin(), table.end(), [](reward_type entry) { return entry == 0; }));
+            std::fill(table.begin(), table.end(), 1);
+        }
+        Table<action_type> policy(size);
+        EXPECT_TRUE(std::all_of(policy.begin(), policy.end(), [](action_type entry) { return entry == action_type{}; }));
+    }
+}
+
+TEST(SolverTest, TimePolicyHoldsThePolicyOfEveryStep) {
+    SKIP_IF_STATE_SPACE_LARGER_THAN(1e5);
+
+    for (int processes : {1, 2}) {
+        SCOPED_TRACE(processes);
+        SolverOptions options;
+        options.processes = processes;
+        options.time_policy_path = testing::TempDir() + "solver_time_policy_" + std::to_string(State::ROWS)
+                                   + "x" + std::to_string(State::COLS);
+        const Solution full = solve(options);
+
+        const MappedTimePolicy time_policy = MappedTimePolicy::open(options.time_policy_path);
+        ASSERT_EQ(kHorizon, time_policy.header().steps);
+        EXPECT_EQ(kHorizon - 1, time_policy.header().first_time);
+        EXPECT_LE(time_policy.header().block_count, kHorizon * time_policy.header().table_blocks());
+        // time t leaves kHorizon - t moves, the last step of a solve with that horizon
+        for (int time = 0; time < kHorizon; time++) {
+            const Solution shorter = solve(SolverOptions(), kObjective, kHorizon - time);
+            int64_t differences = 0;
+            for (int64_t position = 0; position < static_cast<int64_t>(shorter.policy.size()); position++) {
+                differences += time_policy.action(time, position) != shorter.policy[position];
+            }
+            EXPECT_EQ(0, differences) << "time " << time;
+        }
+        int64_t last_step_differences = 0;
+        for (int64_t position = 0; position < static_cast<int64_t>(full.policy.size()); position++) {
+            last_step_differences += time_policy.action(-5, position) != full.policy[position];
+        }
+        EXPECT_EQ(0, last_step_differences);
+        std::remove(options.time_policy_path.c_str());
+    }
+}
+
+// Integer field of a line of a metrics file, -1 when it is missing
+static int64_t metrics_field(const std::string& line, const std::string& key) {
+    const size_t at = line.find("\"" + key + "\":");
+    return at == std::string::npos ? -1 : std::stoll(line.substr(at + key.size() + 3));
+}
+
+TEST(SolverTest, MetricsCountTheSameWorkInEverySweep) {
+    SKIP_IF_STATE_SPACE_LARGER_THAN(1e5);
+
+    const std::string path = testing::TempDir() + "solver_metrics_" + std::to_string(State::ROWS)
+                             + "x" + std::to_string(State::COLS) + ".jsonl";
+    std::vector<std::vector<int64_t>> reference;
+    for (int mode = 0; mode < 4; mode++) {
+        SCOPED_TRACE(mode);
+        SolverOptions options;
+        options.metrics_path = path;
+        options.threads = mode == 1 ? 3 : 1;
+        options.processes = mode == 2 ? 2 : 1;
+        options.precompute_transitions = mode == 3;
+        const Solution solution = solve(options);
+
+        std::ifstream in(path);
+        std::string line;
+        std::vector<std::vector<int64_t>> steps;
+        while (std::getline(in, line)) {
+            ASSERT_EQ(static_cast<int64_t>(steps.size()) + 1, metrics_field(line, "step")) << line;
+            EXPECT_EQ(kHorizon - 1 - static_cast<int64_t>(steps.size()), metrics_field(line, "time"));
+            EXPECT_EQ(static_cast<int64_t>(solution.policy.size()) - 1, metrics_field(line, "states"));
+            EXPECT_GT(metrics_field(line, "successors"), metrics_field(line, "valid_moves"));
+            EXPECT_GT(metrics_field(line, "peak_rss_bytes"), 0);
+            EXPECT_EQ(-1, metrics_field(line, "max_change"));
+            EXPECT_EQ(mode == 2, metrics_field(line, "worker_peak_rss_bytes") > 0);
+            steps.push_back({metrics_field(line, "valid_moves"), metrics_field(line, "successors"),
+                             metrics_field(line, "policy_changes")});
+        }
+        ASSERT_EQ(kHorizon, static_cast<int>(steps.size()));
+        // the first step starts from the zeroed policy table, states whose best move differs change
+        EXPECT_GT(steps[0][2], 0);
+        if (mode == 0) {
+            reference = steps;
+        } else {
+            EXPECT_EQ(reference, steps);
+        }
+    }
+    std::remove(path.c_str());
+}
+
+TEST(SolverTest, ObjectiveLanesMatchTheSolveOfEachObjective) {
+    SKIP_IF_STATE_SPACE_LARGER_THAN(1e5);
+
+    const ObjectiveLanes lanes{2, kObjective};
+    const int64_t table_size = state_space_size(kObjective);
+    for (bool precompute_transitions : {false, true}) {
+        SCOPED_TRACE(precompute_transitions);
+        SolverOptions options;
+        options.threads = 3;
+        options.precompute_transitions = precompute_transitions;
+        Table<action_type> policy(table_size * lanes.count());
+        Table<reward_type> value(table_size * lanes.count());
+        Table<reward_type> new_value(table_size * lanes.count());
+        ASSERT_EQ(kHorizon, optimal_policies(policy, value, new_value, lanes, kHorizon, DenseIndex(table_size), options));
+
+        for (int objective = lanes.first; objective <= lanes.last; objective++) {
+            SCOPED_TRACE(objective);
+            const Solution single = solve(SolverOptions(), objective);
+            for (int64_t hash = 0; hash < static_cast<int64_t>(single.value.size()); hash++) {
+                State board;
+                hash_to_gamestate(objective, hash, board);
+                const int64_t entry = gamestate_to_hash(kObjective, board) * lanes.count() + lanes.lane(objective);
+                ASSERT_EQ(single.value[hash], value[entry]) << hash;
+                // Note: won boards are worth 1 whatever the action, their policy is not compared
+                if (final_reward(objective, board) == 0) {
+                    ASSERT_EQ(single.policy[hash], policy[entry]) << hash;
+                }
+            }
+        }
+    }
+}
+
+TEST(SolverTest, PrioritizedSweepingReachesTheFixedPointOfFullSweeps) {
+    SKIP_IF_STATE_SPACE_LARGER_THAN(1e5);
+
+    SolverOptions sweeps;
+    sweeps.tolerance = 0;
+    const Solution expected = solve(sweeps, kObjective, completion_time_horizon(kObjective));
+
+    const int64_t table_size = static_cast<int64_t>(expected.value.size());
+    Solution prioritized;
+    prioritized.policy.resize(table_size);
+    prioritized.value.resize(table_size);
+    SolverOptions options;
+    options.threads = 3;
+    const PrioritizedSweepReport report = optimal_policy_prioritized(prioritized.policy, prioritized.value, kObjective,
+                                                                     DenseIndex(table_size), options);
+    expect_identical(expected, prioritized);
+    EXPECT_TRUE(report.converged);
+    EXPECT_EQ(table_size, report.states);
+    EXPECT_GT(report.predecessors, 0);
+    // Note: the sweeps take 11 passes over every board to converge on 2x2, 12 on 2x3
+    EXPECT_LT(report.full_sweeps(), 2);
+}
+
+TEST(SolverTest, SearchToTheHorizonMatchesTheSolvedValues) {
+    SKIP_IF_STATE_SPACE_LARGER_THAN(1e5);
+
+    const Solution solution = solve(SolverOptions());
+    SearchOptions options;
+    options.seconds_per_move = 0;
+    options.min_probability = 0;
+    options.threads = 3;
+    ExpectimaxSearch search(kObjective, options);
+
+    // every board with up to two tiles, the search looks kHorizon moves ahead like the solve
+    int searched = 0;
+    for (int64_t hash = 1; hash < static_cast<int64_t>(solution.value.size()); hash++) {
+        State board;
+        hash_to_gamestate(kObjective, hash, board);
+        if (board.count_empty_tiles() < State::SIZE - 2) continue;
+        const SearchResult result = search.search(board, kHorizon);
+        ASSERT_NEAR(solution.value[hash], result.value, 1e-9) << hash;
+        // Note: won boards are not searched
+        if (final_reward(kObjective, board) == 0) {
+            ASSERT_NEAR(result.value, result.action_values[static_cast<int>(solution.policy[hash])], 1e-9) << hash;
+            EXPECT_EQ(kHorizon, result.depth);
+            searched++;
+        }
+    }
+    EXPECT_EQ(searched, search.statistics().moves);
+    EXPECT_GT(search.statistics().hits, 0);
+}
+
+TEST(SolverTest, ReachableSolveMatchesDenseOnReachableBoards) {
+    SKIP_IF_STATE_SPACE_TOO_LARGE();
+
+    const Solution dense = solve(SolverOptions());
+
+    util::ThreadPool pool(3);
+    const ReachableIndex reachable = ReachableIndex::build(kObjective, pool);
+    ASSERT_GT(reachable.size(), 1);
+    ASSERT_LT(reachable.size(), static_cast<int64_t>(dense.value.size()));
+
+    for (bool precompute_transitions : {false, true}) {
+        SolverOptions options;
+        options.threads = 2;
+        options.precompute_transitions = precompute_transitions;
+
+        Table<action_type> policy(reachable.size());
+        Table<reward_type> value(reachable.size());
+        Table<reward_type> new_value(reachable.size());
+        optimal_policy(policy, value, new_value, kObjective, kHorizon, reachable, options);
+
+        for (int64_t position = 0; position < reachable.size(); position++) {
+            const int64_t hash = reachable.hash_at(position);
+            ASSERT_EQ(reachable.position(hash), position);
+            ASSERT_EQ(dense.value[hash], value[position]) << hash;
+            ASSERT_EQ(dense.policy[hash], policy[position]) << hash;
+        }
+    }
+}
+
+TEST(SolverTest, SparseIndexHoldsTheReachableBoards) {
+    SKIP_IF_STATE_SPACE_LARGER_THAN(1e5);
+
+    util::ThreadPool pool(3);
+    const ReachableIndex reachable = ReachableIndex::build(kObjective, pool);
+    const SparseIndex sparse = SparseIndex::build(kObjective, pool);
+    ASSERT_EQ(reachable.size(), sparse.size());
+    // both store the boards in increasing hash order
+    for (int64_t position = 0; position < sparse.size(); position++) {
+        ASSERT_EQ(reachable.hash_at(position), sparse.hash_at(position));
+        ASSERT_EQ(position, sparse.position(sparse.hash_at(position)));
+    }
+    for (int64_t hash = 0; hash < sparse.total_combinations(); hash++) {
+        ASSERT_EQ(reachable.contains(hash), sparse.contains(hash)) << hash;
+    }
+
+    SolverOptions options;
+    options.threads = 2;
+    Table<action_type> policy(sparse.size());
+    Table<reward_type> value(sparse.size());
+    Table<reward_type> new_value(sparse.size());
+    optimal_policy(policy, value, new_value, kObjective, kHorizon, sparse, options);
+
+    Solution expected;
+    expected.policy.resize(reachable.size());
+    expected.value.resize(reachable.size());
+    optimal_policy(expected.policy, expected.value, new_value, kObjective, kHorizon, reachable, options);
+    expect_identical(expected, Solution{policy, value});
+}
+
+TEST(SolverTest, StateSpaceSizeRejectsOverflow) {
+    EXPECT_EQ(std::llround(std::pow(kObjective + 1, State::SIZE)), state_space_size(kObjective));
+    EXPECT_THROW(state_space_size(1 << 20), std::overflow_error);
+}
+
+TEST(SolverTest, SymmetricSolveMatchesDenseOnEveryBoard) {
+    // Note: builds two symmetric indexes and checks every action, a smaller limit than the other tests
+    SKIP_IF_STATE_SPACE_LARGER_THAN(5e5);
+
+    const Solution dense = solve(SolverOptions());
+    // values one time step later, what the actions of the first step are worth
+    const Solution next = solve(SolverOptions(), kObjective, kHorizon - 1);
+
+    util::ThreadPool pool(2);
+    const ReachableIndex reachable = ReachableIndex::build(kObjective, pool);
+    for (const ReachableIndex* restriction : {static_cast<const ReachableIndex*>(nullptr), &reachable}) {
+        const SymmetricIndex symmetric = SymmetricIndex::build(kObjective, pool, restriction);
+        ASSERT_LT(symmetric.size() * 3, static_cast<int64_t>(dense.value.size()));
+
+        SolverOptions options;
+        options.precompute_transitions = restriction != nullptr;
+        Table<action_type> policy(symmetric.size());
+        Table<reward_type> value(symmetric.size());
+        Table<reward_type> new_value(symmetric.size());
+        optimal_policy(policy, value, new_value, kObjective, kHorizon, symmetric, options);
+
+        State gamestate;
+        for (int64_t hash = 0; hash < static_cast<int64_t>(dense.value.size()); hash++) {
+            if (restriction != nullptr && !restriction->contains(hash)) continue;
+            const int64_t position = symmetric.position(hash);
+            // successors are summed in a different order, values agree up to rounding
+            ASSERT_NEAR(dense.value[hash], value[position], 1e-12) << hash;
+
+            // the action mapped back to this board must be a valid move, worth the dense optimum
+            hash_to_gamestate(kObjective, hash, gamestate);
+            const auto canonical = canonical_hash(kObjective, hash);
+            const action_type action = apply(inverse(canonical.symmetry), policy[position]);
+            ASSERT_EQ(action == Action::None, dense.policy[hash] == Action::None) << hash;
+            reward_type action_value = next.value[hash];
+            if (action != Action::None) {
+                const std::optional<State> afterstate = gamestate.player_move(action);
+                ASSERT_TRUE(afterstate.has_value()) << hash;
+                const std::vector<Coord> tiles = afterstate->all_nature_moves();
+                action_value = 0;
+                for (const Coord& tile : tiles) {
+                    for (int8_t power : {int8_t(1), int8_t(2)}) {
+                        State successor = afterstate.value();
+                        successor(tile.i, tile.j) = power;
+                        action_value += next.value[gamestate_to_hash(kObjective, successor)] / (2 * tiles.size());
+                    }
+                }
+            }
+            ASSERT_NEAR(dense.value[hash], action_value, 1e-12) << hash << " " << action;
+        }
+    }
+}
+
+TEST(SolverTest, CompletionSolveMatchesConvergedSweep) {
+    SKIP_IF_STATE_SPACE_LARGER_THAN(5e5);
+
+    // long enough for every board to converge
+    const Solution converged = solve(SolverOptions(), kObjective, completion_time_horizon(kObjective));
+
+    const DenseIndex dense(static_cast<int64_t>(converged.value.size()));
+    for (int threads : {1, 3}) {
+        SolverOptions options;
+        options.threads = threads;
+        Solution layered;
+        layered.policy.resize(dense.size());
+        layered.value.resize(dense.size());
+        optimal_policy_to_completion(layered.policy, layered.value, kObjective, dense, options);
+        expect_identical(converged, layered);
+    }
+}
+
+TEST(SolverTest, ConvergenceStopsWithConvergedValues) {
+    SKIP_IF_STATE_SPACE_LARGER_THAN(5e5);
+
+    const int T = completion_time_horizon(kObjective);
+    const Solution converged = solve(SolverOptions(), kObjective, T);
+
+    // stopping once values are fixed gives exactly the full run
+    SolverOptions early_stop;
+    early_stop.tolerance = 0;
+    early_stop.threads = 2;
+    expect_identical(converged, solve(early_stop, kObjective, T));
+
+    // in place updates reach the same fixed point, without new_value
+    SolverOptions in_place;
+    in_place.tolerance = 0;
+    in_place.gauss_seidel = true;
+    const int64_t total_combinations = static_cast<int64_t>(converged.value.size());
+    Table<action_type> policy(total_combinations);
+    Table<reward_type> value(total_combinations);
+    Table<reward_type> no_new_value;
+    optimal_policy(policy, value, no_new_value, kObjective, T, in_place);
+    for (int64_t hash = 0; hash < total_combinations; hash++) {
+        ASSERT_NEAR(converged.value[hash], value[hash], 1e-12) << hash;
+    }
+}
+
+namespace {
+
+// Largest difference with the double solve when values are stored as Storage
+template <typename Storage>
+reward_type max_storage_error(const Solution& reference) {
+    const DenseIndex dense(static_cast<int64_t>(reference.value.size()));
+    Table<action_type> policy(dense.size());
+    Table<Storage> value(dense.size());
+    Table<Storage> new_value(dense.size());
+    optimal_policy(policy, value, new_value, kObjective, kHorizon, dense, SolverOptions());
+    reward_type worst_error = 0;
+    for (int64_t hash = 0; hash < dense.size(); hash++) {
+        worst_error = std::max(worst_error, std::abs(decode_value(value[hash]) - reference.value[hash]));
+    }
+    return worst_error;
+}
+
+}  // namespace
+
+TEST(SolverTest, CompactValuesStayWithinRoundingOfDouble) {
+    SKIP_IF_STATE_SPACE_LARGER_THAN(5e5);
+
+    const Solution reference = solve(SolverOptions());
+
+    // double storage through the index template is the original solver
+    EXPECT_EQ(0, max_storage_error<double>(reference));
+
+    // a backup never increases differences, so each time step adds at most half a step of rounding
+    EXPECT_LE(max_storage_error<float>(reference), kHorizon * 1e-7);
+    EXPECT_LE(max_storage_error<Fixed16>(reference), kHorizon * 0.5 / 65535);
+    EXPECT_LE(max_storage_error<Quantized8>(reference), kHorizon * 0.5 / 255);
+    EXPECT_GT(max_storage_error<Quantized8>(reference), 0);
+}
+
+TEST(SolverTest, ResumedSolveMatchesUninterruptedSolve) {
+    SKIP_IF_STATE_SPACE_LARGER_THAN(5e5);
+
+    const Solution full = solve(SolverOptions());
+
+    // a shorter horizon extended by the missing time steps
+    Solution extended = solve(SolverOptions(), kObjective, kHorizon - 3);
+    Table<reward_type> new_value(extended.value.size());
+    SolverOptions resume;
+    resume.resume_steps = kHorizon - 3;
+    EXPECT_EQ(kHorizon, optimal_policy(extended.policy, extended.value, new_value, kObjective, kHorizon, resume));
+    expect_identical(full, extended);
+
+    // checkpoints after every time step, the last one is one step short of the horizon
+    SolverOptions checkpointed;
+    checkpointed.checkpoint.path = testing::TempDir() + "solver_checkpoint_" + std::to_string(State::ROWS)
+                                   + "x" + std::to_string(State::COLS);
+    checkpointed.checkpoint.interval_seconds = 0;
+    checkpointed.checkpoint.header.rows = State::ROWS;
+    checkpointed.checkpoint.header.cols = State::COLS;
+    checkpointed.checkpoint.header.winning_objective = kObjective;
+    expect_identical(full, solve(checkpointed));
+
+    const MappedSolution checkpoint = MappedSolution::open(checkpointed.checkpoint.path);
+    ASSERT_EQ(kHorizon - 1, checkpoint.header().horizon);
+    Solution resumed;
+    resumed.policy.assign(checkpoint.policy(), checkpoint.policy() + checkpoint.header().table_size);
+    resumed.value.assign(checkpoint.values<reward_type>(),
+                         checkpoint.values<reward_type>() + checkpoint.header().table_size);
+    resume.resume_steps = checkpoint.header().horizon;
+    optimal_policy(resumed.policy, resumed.value, new_value, kObjective, kHorizon, resume);
+    expect_identical(full, resumed);
+    std::remove(checkpointed.checkpoint.path.c_str());
+}
@@ -1,9 +1,18 @@
 #include "state.hpp"
 #include "utils.hpp"
+#include "symmetry.hpp"
+#include "successor_kernel.hpp"
+#include "move_table.hpp"
 
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
 #include <vector>
 
+using namespace BOARD_NAMESPACE;
+
 namespace {
 
 #define SKIP_UNLESS_BOARD_2X3()                                            \
@@ -116,3 +125,148 @@ TEST(StateHashTest, HashRoundTripPreservesState) {
 
     EXPECT_EQ(from_hash, gamestate);
 }
+
+TEST(SuccessorKernelTest, MatchesBoardSuccessors) {
+    // objective 1 clamps the 4 tiles, like gamestate_to_hash
+    for (int objective : {1, 2, 5}) {
+        const int64_t total = std::min<int64_t>(state_space_size(objective), 50000);
+        SuccessorKernel kernel(objective);
+        State expected;
+        int64_t successors[SuccessorKernel::MAX_SUCCESSORS];
+        // consecutive hashes step the odometer, the jumps decode the hash
+        for (int64_t hash = 0; hash < total; hash += hash % 97 == 0 ? 13 : 1) {
+            hash_to_gamestate(objective, hash, expected);
+            ASSERT_EQ(expected, kernel.seek(hash)) << hash;
+            for (auto a : Actions::All) {
+                const int length = kernel.successors(a, successors);
+                const auto next_state = expected.player_move(a);
+                if (!next_state.has_value()) {
+                    ASSERT_EQ(0, length) << hash << a;
+                    continue;
+                }
+                const std::vector<Coord> nature = next_state->all_nature_moves();
+                ASSERT_EQ(static_cast<int>(nature.size() * 2), length) << hash << a;
+                State nature_move(*next_state);
+                for (std::size_t k = 0; k < nature.size(); k++) {
+                    nature_move(nature[k].i, nature[k].j) = 1;
+                    ASSERT_EQ(gamestate_to_hash(objective, nature_move), successors[2 * k]) << hash << a;
+                    nature_move(nature[k].i, nature[k].j) = 2;
+                    ASSERT_EQ(gamestate_to_hash(objective, nature_move), successors[2 * k + 1]) << hash << a;
+                    nature_move(nature[k].i, nature[k].j) = 0;
+                }
+            }
+        }
+    }
+}
+
+namespace {
+
+// Compares the lookup-table move with the legacy shifting move for every action
+void expect_same_moves(const State& gamestate) {
+    for (auto a : Actions::All) {
+        const auto expected = gamestate.player_move_legacy(a);
+        const auto actual = gamestate.player_move(a);
+        ASSERT_EQ(expected.has_value(), actual.has_value()) << gamestate << a;
+        if (expected.has_value()) {
+            ASSERT_EQ(*expected, *actual) << gamestate << a;
+        }
+    }
+}
+
+}  // namespace
+
+TEST(StateMoveTableTest, MatchesLegacyMoveOnEveryBoard) {
+    // largest tile value such that all boards can be enumerated in a unit test
+    int max_tile = 1;
+    while (max_tile < 15 && std::pow(max_tile + 2, State::SIZE) <= 2e6) {
+        max_tile++;
+    }
+
+    State gamestate;
+    const int64_t total = std::llround(std::pow(max_tile + 1, State::SIZE));
+    for (int64_t hash = 0; hash < total; hash++) {
+        hash_to_gamestate(max_tile, hash, gamestate);
+        expect_same_moves(gamestate);
+    }
+}
+
+TEST(StateMoveTableTest, MatchesLegacyMoveOnEveryTableLine) {
+    // every row and column of the tables, including tiles 2^16 that fall back
+    // to the legacy move when the board can store them
+#ifdef PACKED_STATE
+    // Note: tiles up to 2^14, so that merges still fit in 4 bits
+    constexpr int kTileValues = PackedBoard::MAX_TILE;
+#else
+    constexpr int kTileValues = 17;
+#endif
+    for (int line_length : {State::COLS, State::ROWS}) {
+        const int64_t total = std::llround(std::pow(kTileValues, line_length));
+        for (int64_t key = 0; key < total; key++) {
+            State first_row;
+            State first_column;
+            int64_t digits = key;
+            for (int k = 0; k < line_length; k++) {
+                const auto tile = static_cast<int8_t>(digits % kTileValues);
+                digits /= kTileValues;
+                if (line_length == State::COLS) first_row(0, k) = tile;
+                if (line_length == State::ROWS) first_column(k, 0) = tile;
+            }
+            expect_same_moves(first_row);
+            expect_same_moves(first_column);
+        }
+    }
+}
+
+TEST(StateMoveTableTest, MergeBeyondFourBitsIsFlagged) {
+    using MoveTable = LineMoveTable<State::COLS>;
+    std::array<int8_t, State::COLS> line{};
+    line[0] = MoveTable::MAX_TILE;
+    line[1] = MoveTable::MAX_TILE;
+    const MoveTable::Entry entry = MoveTable::slide(line);
+    EXPECT_TRUE(entry.overflows);
+    EXPECT_EQ(MoveTable::MAX_TILE + 1, entry.tiles[0]);
+    line[0] = line[1] = MoveTable::MAX_TILE - 1;
+    EXPECT_FALSE(MoveTable::slide(line).overflows);
+
+#ifdef PACKED_STATE
+    // Note: the merged 2^16 tile cannot be stored, the move throws instead of dropping it
+    State gamestate;
+    gamestate(0, 0) = PackedBoard::MAX_TILE;
+    gamestate(0, 1) = PackedBoard::MAX_TILE;
+    EXPECT_THROW(gamestate.player_move(Action::Left), std::overflow_error);
+    EXPECT_THROW(gamestate.player_move(Action::Right), std::overflow_error);
+    gamestate(0, 1) = PackedBoard::MAX_TILE - 1;
+    EXPECT_TRUE(gamestate.player_move(Action::Right).has_value());
+    gamestate(1, 0) = PackedBoard::MAX_TILE;
+    EXPECT_THROW(gamestate.player_move(Action::Up), std::overflow_error);
+#endif
+}
+
+TEST(StateSymmetryTest, MovesCommuteWithSymmetries) {
+    constexpr int kMaxTile = 3;
+    State gamestate;
+    const int64_t total = std::llround(std::pow(kMaxTile + 1, State::SIZE));
+    // a spread of boards is enough, every symmetry is a fixed permutation of tiles
+    const int64_t step = std::max<int64_t>(1, total / 20000);
+    for (int64_t hash = 0; hash < total; hash += step) {
+        hash_to_gamestate(kMaxTile, hash, gamestate);
+        const auto canonical = canonical_hash(kMaxTile, gamestate);
+        ASSERT_EQ(gamestate_to_hash(kMaxTile, apply(canonical.symmetry, gamestate)), canonical.hash);
+
+        for (int g = 0; g < Symmetries::COUNT; g++) {
+            const auto symmetry = Symmetry(g);
+            const State transformed = apply(symmetry, gamestate);
+            ASSERT_EQ(apply(inverse(symmetry), transformed), gamestate);
+            ASSERT_EQ(canonical_hash(kMaxTile, transformed).hash, canonical.hash);
+
+            for (auto a : Actions::All) {
+                const auto expected = gamestate.player_move(a);
+                const auto actual = transformed.player_move(apply(symmetry, a));
+                ASSERT_EQ(expected.has_value(), actual.has_value()) << gamestate << a;
+                if (expected.has_value()) {
+                    ASSERT_EQ(apply(symmetry, *expected), *actual) << gamestate << a;
+                }
+            }
+        }
+    }
+}